@@ -0,0 +1,109 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include "linesblock.h"
+#include "autotuner.h"
+
+namespace fwc {
+
+Autotuner::Autotuner(size_t numOfConsumers, size_t queueSize):
+    _filterTime(numOfConsumers),
+    _activeConsumers(numOfConsumers),
+    _queueSize(queueSize) {
+
+    assert(numOfConsumers > 0);
+    assert(queueSize > 0);
+}
+
+void Autotuner::reset(size_t maxBudget) {
+
+    assert(maxBudget > 0);
+
+    _candidates.clear();
+    if(maxBudget != BlockLimits::NO_BYTES_LIMIT) {
+        for(size_t budget = MIN_BUDGET; budget < maxBudget; budget *= 4) {
+            _candidates.push_back(budget);
+            if(budget > SIZE_MAX / 4) {
+                // the next candidate would overflow
+                break;
+            }
+        }
+    }
+    _candidates.push_back(maxBudget);
+
+    _throughputs.clear();
+    _candidate = 0;
+    _budget = _candidates[0];
+    _phaseBytes = 0;
+    _phaseBlocks = 0;
+    _measuring = false;
+    _readTime = Clock::duration::zero();
+
+    for(auto& time: _filterTime) {
+        time.store(0, std::memory_order_relaxed);
+    }
+    _activeConsumers.store(_filterTime.size(), std::memory_order_relaxed);
+    _tuned.store(false, std::memory_order_relaxed);
+}
+
+void Autotuner::blockRead(size_t bytes, Clock::duration time) {
+
+    if(tuned()) {
+        return;
+    }
+
+    _readTime += time;
+    _phaseBytes += bytes;
+    ++_phaseBlocks;
+
+    if(!_measuring) {
+        // the queue can be full of blocks of the previous size
+        if(_phaseBlocks > _queueSize) {
+            _measuring = true;
+            _phaseBytes = 0;
+            _phaseBlocks = 0;
+            _phaseStart = Clock::now();
+        }
+        return;
+    }
+
+    if(_phaseBytes < PROBE_SIZE || _phaseBlocks <= _queueSize) {
+        return;
+    }
+
+    const auto elapsed = std::chrono::duration<double>(Clock::now() - _phaseStart).count();
+    _throughputs.push_back(_phaseBytes / std::max(elapsed, 1e-9));
+
+    if(++_candidate < _candidates.size()) {
+        _budget = _candidates[_candidate];
+        _measuring = false;
+        _phaseBytes = 0;
+        _phaseBlocks = 0;
+        return;
+    }
+
+    finish();
+}
+
+void Autotuner::finish() {
+
+    auto best = std::max_element(_throughputs.begin(), _throughputs.end());
+    _budget = _candidates[best - _throughputs.begin()];
+
+    Clock::rep filterTime = 0;
+    for(auto& time: _filterTime) {
+        filterTime += time.load(std::memory_order_relaxed);
+    }
+
+    // consumers which can keep up with the producer
+    const double ratio = static_cast<double>(filterTime) / std::max<Clock::rep>(_readTime.count(), 1);
+    const size_t needed = static_cast<size_t>(std::ceil(ratio));
+    _activeConsumers.store(std::clamp<size_t>(needed, 1, _filterTime.size()),
+                                                    std::memory_order_relaxed);
+
+    _tuned.store(true, std::memory_order_relaxed);
+}
+
+} // namespace fwc
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+#include "noncopyable.h"
+
+namespace fwc {
+
+/*
+Autotuning of a producer-consumer processor during the first MBs of a file.
+The best byte budget of blocks and the number of consumers depend on the
+file and the machine, so they are measured instead of being configured.
+
+The producer tries candidate budgets from MIN_BUDGET up to the preallocated
+one (x4 each step). For each candidate it skips blocks while the queue is
+refilled with blocks of the new size and then measures throughput of reading
+of at least PROBE_SIZE bytes. The queue is full all this time if consumers are
+slower, so the producer's rate is the rate of the whole pipeline.
+The best candidate is kept for the rest of the file.
+
+Busy time of the producer (reading) and of consumers (filtering) is summed
+during probing, the number of active consumers is their ratio: more consumers
+than it only wait for blocks.
+*/
+
+class Autotuner final: private noncopyable
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    constexpr static size_t MIN_BUDGET = 16*1024;
+    constexpr static size_t PROBE_SIZE = 2*1024*1024;
+
+    Autotuner(size_t numOfConsumers, size_t queueSize);
+
+    // it must be called before processing of a file, 'maxBudget' is the
+    // byte budget of preallocated blocks (it can be unlimited, then only
+    // the number of consumers is tuned)
+    void reset(size_t maxBudget);
+
+    // byte budget of the next block, it is called in producer thread
+    [[nodiscard]]
+    size_t budget() const noexcept { return _budget; }
+
+    // consumers with indexes not less than it don't take blocks
+    [[nodiscard]]
+    size_t activeConsumers() const noexcept {
+        return _activeConsumers.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]]
+    bool tuned() const noexcept { return _tuned.load(std::memory_order_relaxed); }
+
+    // it is called in producer thread for each block
+    void blockRead(size_t bytes, Clock::duration time);
+
+    // it is called in consumer threads for each block while it's not tuned
+    void blockFiltered(size_t idx, Clock::duration time) noexcept {
+        _filterTime[idx].fetch_add(time.count(), std::memory_order_relaxed);
+    }
+
+private:
+
+    // choose the best budget and the number of consumers
+    void finish();
+
+    std::vector<std::atomic<Clock::rep>> _filterTime;
+    std::vector<size_t> _candidates;
+    std::vector<double> _throughputs;
+    size_t              _candidate   { 0 };
+    size_t              _budget      { 0 };
+    size_t              _phaseBytes  { 0 };
+    size_t              _phaseBlocks { 0 };
+    bool                _measuring   { false };
+    Clock::time_point   _phaseStart;
+    Clock::duration     _readTime    { 0 };
+    std::atomic<size_t> _activeConsumers;
+    std::atomic<bool>   _tuned       { false };
+    const size_t        _queueSize;
+};
+
+} // namespace fwc
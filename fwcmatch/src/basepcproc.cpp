@@ -2,51 +2,138 @@
 #include <cassert>
 #include <algorithm>
 
+#include "utils.h"
+#include "proctools.h"
 #include "basepcproc.h"
 
 #define PRODUCER_HAS_OWN_THREAD 0 // just for some experiment
 
 namespace fwc {
 
-BaseProdConsProcessor::BaseProdConsProcessor(size_t numOfConsumers):
+#if PRODUCER_HAS_OWN_THREAD
+static constexpr size_t PRODUCER_THREADS = 1;
+#else
+static constexpr size_t PRODUCER_THREADS = 0;
+#endif
+
+BaseProdConsProcessor::BaseProdConsProcessor(size_t numOfConsumers, ThreadPool* pool):
     _counters(numOfConsumers, 0),
-    _numOfConsThreads(numOfConsumers) {
+    _matched(numOfConsumers),
+    _numOfConsThreads(numOfConsumers),
+    _pool(pool) {
 
     assert(numOfConsumers > 0);
+
+    if(!_pool) {
+        _ownPool = std::make_unique<ThreadPool>(_numOfConsThreads + PRODUCER_THREADS);
+        _pool = _ownPool.get();
+    }
+
+    if(_pool->size() < _numOfConsThreads + PRODUCER_THREADS) {
+        errorAndStop("Thread pool is too small for the processor", false);
+    }
 }
 
 BaseProdConsProcessor::~BaseProdConsProcessor() {
 }
 
 size_t BaseProdConsProcessor::execute(FileReader& freader, const std::string& filename,
-                                WildcardMatch& wcmatch, const std::string& pattern) {
+                                const CompiledPattern& cpattern, LineSink* sink) {
+
+    // blocks are queued while next ones are read
+    if(!freader.keepsLines()) {
+        errorAndStop("File reader doesn't keep lines of previous blocks", false);
+    }
 
     // std::fill works slowly :(
     _counters.assign(_counters.size(), 0);
+    _sink = sink;
+    _nextSeqNo = 0;
+    if(_reorder) {
+        _reorder->reset(sink, freader.needsBuffer());
+    }
 
     init();
     ScopedFileOpener fopener(freader, filename);
 
-    std::vector<std::thread> threads;
-    threads.reserve(_numOfConsThreads + 1);
-    for(size_t i = 0; i < _numOfConsThreads; ++i) {
-        threads.emplace_back(&BaseProdConsProcessor::filterLines,
-                            this, i, std::ref(wcmatch), std::cref(pattern));
-    }
+    auto threadFunc = [&](size_t idx) {
+        if(idx < _numOfConsThreads) {
+            filterLines(idx, cpattern);
+        }
+        else {
+            readFileLines(freader);
+        }
+    };
 
-#if PRODUCER_HAS_OWN_THREAD
-    threads.emplace_back(&BaseMTProcessor::readFileLines, this, std::ref(freader));
-#else
+    _pool->run(_numOfConsThreads + PRODUCER_THREADS, threadFunc);
+
+#if ! PRODUCER_HAS_OWN_THREAD
     readFileLines(freader);
 #endif
 
-    for(auto& t: threads) {
-        t.join();
-    }
+    _pool->wait();
+
+    assert(!_reorder || !_sink || _reorder->nextSeqNo() == _nextSeqNo);
 
     return calcFinalResult();
 }
 
+void BaseProdConsProcessor::setOrderedOutput(size_t windowSize) {
+
+    if(windowSize) {
+        _reorder = std::make_unique<ReorderBuffer>(windowSize);
+    }
+    else {
+        _reorder.reset();
+    }
+}
+
+template<typename Block>
+size_t BaseProdConsProcessor::filterBlock(size_t idx, const CompiledPattern& cpattern,
+                                                        Block const& block) {
+    if(!_sink || block.empty()) {
+        // an empty block is only an end of file mark and it has no number
+        return proctools::filterBlock(cpattern, block);
+    }
+
+    auto& matched = _matched[idx];
+    if(matched.capacity() < block.maxLines()) {
+        // it happens only once for the first block
+        matched.reserve(block.maxLines());
+    }
+
+    if(!_reorder) {
+        return proctools::filterBlock(cpattern, block, _sink, matched);
+    }
+
+    // blocks without found lines are put too, they move the window
+    auto counter = proctools::filterBlock(cpattern, block, matched);
+    _reorder->put(block.seqNo(), matched);
+
+    return counter;
+}
+
+template<typename Block>
+void BaseProdConsProcessor::readInLinesBlock(FileReader& freader, Block& block,
+                                                                size_t endOffset) {
+
+    if(_reorder && _sink) {
+        _reorder->waitForSlot(_nextSeqNo);
+    }
+
+    proctools::readInLinesBlock(freader, block, endOffset);
+    if(!block.empty()) {
+        block.setSeqNo(_nextSeqNo++);
+    }
+}
+
+template size_t BaseProdConsProcessor::filterBlock(size_t, const CompiledPattern&,
+                                                        LinesBlock const&);
+template size_t BaseProdConsProcessor::filterBlock(size_t, const CompiledPattern&,
+                                                        CompactLinesBlock const&);
+template void BaseProdConsProcessor::readInLinesBlock(FileReader&, LinesBlock&, size_t);
+template void BaseProdConsProcessor::readInLinesBlock(FileReader&, CompactLinesBlock&, size_t);
+
 size_t BaseProdConsProcessor::calcFinalResult() const {
 
     return std::accumulate(_counters.begin(), _counters.end(),
@@ -5,28 +5,59 @@
 #include <numeric>
 #include <algorithm>
 #include <vector>
-#include <thread>
+#include <limits>
+#include <memory>
 
 #include "noncopyable.h"
 #include "linesblock.h"
 #include "wildcard.h"
 #include "filereader.h"
+#include "threadpool.h"
+#include "linesink.h"
+#include "reorderbuffer.h"
 
 namespace fwc {
 
 // Base class for producer-consumer implementations
+// Threads are taken from a thread pool which is created once with processor
+// or it can be given from outside to share it between processors.
 class BaseProdConsProcessor: private noncopyable
 {
 public:
 
-    BaseProdConsProcessor(size_t numOfConsumers);
+    BaseProdConsProcessor(size_t numOfConsumers, ThreadPool* pool = nullptr);
     virtual ~BaseProdConsProcessor();
 
+    // Found lines are given to the sink in the order of the file if the
+    // window is not zero. The window is the max number of blocks which can be
+    // processed ahead of the oldest unfinished block. Zero disables ordering.
+    void setOrderedOutput(size_t windowSize);
+
+    // if the sink is not null found lines are written into it
+    size_t execute(FileReader& freader, const std::string& filename,
+                    const CompiledPattern& cpattern, LineSink* sink = nullptr);
+
     size_t execute(FileReader& freader, const std::string& filename,
-                    WildcardMatch& wcmatch, const std::string& pattern);
+                    const WildcardMatch& wcmatch, const std::string& pattern,
+                    LineSink* sink = nullptr) {
+        return execute(freader, filename, *wcmatch.compile(pattern), sink);
+    }
 
 protected:
 
+    // it is called in consumer threads to filter a block, it writes found
+    // lines into the sink of the current execution if any
+    // Returns number of found lines according pattern
+    // Block is LinesBlock or CompactLinesBlock
+    template<typename Block>
+    size_t filterBlock(size_t idx, const CompiledPattern& cpattern, Block const& block);
+
+    // it is called in producer thread to read a block, it numbers blocks and
+    // waits for the reorder window if the output is ordered
+    template<typename Block>
+    void readInLinesBlock(FileReader& freader, Block& block,
+                            size_t endOffset = std::numeric_limits<size_t>::max());
+
     std::vector<size_t> _counters;
 
 private:
@@ -38,13 +69,19 @@ class BaseProdConsProcessor: private noncopyable
     virtual void readFileLines(FileReader& freader) = 0;
 
     // it is called in consumer threads
-    virtual void filterLines(size_t idx, WildcardMatch& wcmatch, const std::string& pattern) = 0;
+    virtual void filterLines(size_t idx, const CompiledPattern& cpattern) = 0;
 
     // gather all counters from all consumers
     // it is called in the 'execute' method after all threads finished
     virtual size_t calcFinalResult() const;
 
-    const size_t  _numOfConsThreads;
+    std::vector<MatchedLines>      _matched;
+    LineSink*                      _sink { nullptr };
+    std::unique_ptr<ReorderBuffer> _reorder;
+    size_t                         _nextSeqNo { 0 };
+    const size_t                   _numOfConsThreads;
+    std::unique_ptr<ThreadPool>    _ownPool;
+    ThreadPool*                    _pool;
 };
 
 } // namespace fwc
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <fnmatch.h>
+
+#include "proctools.h"
+#include "batchproc.h"
+
+namespace fwc {
+
+static constexpr size_t NO_FILE = std::numeric_limits<size_t>::max();
+static constexpr size_t NO_END  = std::numeric_limits<size_t>::max();
+
+BatchProcessor::BatchProcessor(size_t numOfThreads, BlockLimits limits,
+                                const ReaderFactory& factory, size_t chunkSize,
+                                ThreadPool* pool):
+    _workers(numOfThreads),
+    _blocksPool(numOfThreads, limits),
+    _chunkSize(chunkSize),
+    _numOfThreads(numOfThreads),
+    _pool(pool) {
+
+    assert(_numOfThreads > 0);
+    assert(_chunkSize > 0);
+
+    // the calling thread is used as one of threads
+    if(!_pool) {
+        _ownPool = std::make_unique<ThreadPool>(_numOfThreads - 1);
+        _pool = _ownPool.get();
+    }
+    if(_pool->size() < _numOfThreads - 1) {
+        errorAndStop("Thread pool is too small for the processor", false);
+    }
+
+    for(auto& worker: _workers) {
+        worker.reader = factory();
+        worker.openFile = NO_FILE;
+    }
+
+    _blocksPool.reset(_workers.front().reader->needsBuffer());
+    for(auto& worker: _workers) {
+        worker.block = _blocksPool.allocBlock();
+        assert(worker.block);
+    }
+}
+
+BatchProcessor::FileList BatchProcessor::listFiles(const std::string& dirname,
+                                        const std::string& glob, bool recursive) {
+    namespace fs = std::filesystem;
+
+    FileList result;
+    auto addFile = [&](const fs::directory_entry& entry) {
+        if(entry.is_regular_file() &&
+                ::fnmatch(glob.c_str(), entry.path().filename().c_str(), 0) == 0) {
+            result.push_back(entry.path().string());
+        }
+    };
+
+    std::error_code ec;
+    const auto options = fs::directory_options::skip_permission_denied;
+    if(recursive) {
+        for(auto const& entry: fs::recursive_directory_iterator(dirname, options, ec)) {
+            addFile(entry);
+        }
+    }
+    else {
+        for(auto const& entry: fs::directory_iterator(dirname, options, ec)) {
+            addFile(entry);
+        }
+    }
+
+    if(ec) {
+        errorAndStop("Directory listing failed: " + ec.message(), false);
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+void BatchProcessor::makeTasks(const FileList& filenames) {
+
+    _sizes.resize(filenames.size());
+    for(size_t i = 0; i < filenames.size(); ++i) {
+        std::error_code ec;
+        _sizes[i] = std::filesystem::file_size(filenames[i], ec);
+        if(ec) {
+            errorAndStop(filenames[i] + ": " + ec.message(), false);
+        }
+    }
+
+    // all readers are made by one factory, sizes of compressed files
+    // are not sizes of their text so they are never split
+    const bool canSplit = _workers.front().reader->canSeek();
+
+    _tasks.clear();
+    size_t packFirst = 0;
+    size_t packBytes = 0;
+
+    auto addPack = [&](size_t lastFile) {
+        if(packFirst < lastFile) {
+            _tasks.push_back({ packFirst, lastFile, 0, NO_END, packBytes });
+        }
+        packFirst = lastFile;
+        packBytes = 0;
+    };
+
+    for(size_t i = 0; i < filenames.size(); ++i) {
+
+        const size_t size = _sizes[i];
+        if(size <= _chunkSize) {
+            packBytes += size;
+            if(packBytes >= _chunkSize) {
+                addPack(i + 1);
+            }
+            continue;
+        }
+
+        addPack(i);
+        if(!canSplit) {
+            _tasks.push_back({ i, i + 1, 0, NO_END, size });
+            packFirst = i + 1;
+            continue;
+        }
+
+        // big file is split into ranges,
+        // the last one is open to see lines appended to the file
+        const size_t numOfRanges = (size + _chunkSize - 1) / _chunkSize;
+        for(size_t r = 0; r < numOfRanges; ++r) {
+            const size_t begin = size * r / numOfRanges;
+            const size_t end   = size * (r + 1) / numOfRanges;
+            _tasks.push_back({ i, i + 1, begin,
+                                r + 1 < numOfRanges ? end : NO_END, end - begin });
+        }
+        packFirst = i + 1;
+    }
+    addPack(filenames.size());
+
+    std::stable_sort(_tasks.begin(), _tasks.end(),
+        [](auto const& a, auto const& b) { return a.bytes > b.bytes; });
+}
+
+void BatchProcessor::runTask(Worker& worker, const Task& task, const FileList& filenames,
+                                                    const CompiledPattern& cpattern) {
+    auto& reader = *worker.reader;
+    auto& block = *worker.block;
+    const bool isRange = task.begin != 0 || task.end != NO_END;
+
+    for(size_t i = task.firstFile; i < task.lastFile; ++i) {
+
+        // the file is kept open because next task can be a range of the same file
+        if(worker.openFile != i) {
+            reader.close();
+            reader.open(filenames[i]);
+            worker.openFile = i;
+        }
+
+        if(isRange && !reader.seek(task.begin)) {
+            errorAndStop("File reader doesn't support seeking", false);
+        }
+
+        size_t counter = 0;
+        for(;;) {
+            proctools::readInLinesBlock(reader, block, task.end);
+            if(block.lines().empty()) {
+                break;
+            }
+
+            counter += proctools::filterBlock(cpattern, block);
+        }
+
+        std::atomic_ref(_counts[i]).fetch_add(counter, std::memory_order_relaxed);
+    }
+}
+
+size_t BatchProcessor::execute(const FileList& filenames, const CompiledPattern& cpattern) {
+
+    _counts.assign(filenames.size(), 0);
+    makeTasks(filenames);
+    _nextTask.store(0, std::memory_order_relaxed);
+
+    auto threadFunc = [&](size_t idx) {
+        auto& worker = _workers[idx];
+        for(;;) {
+            const auto taskIdx = _nextTask.fetch_add(1, std::memory_order_relaxed);
+            if(taskIdx >= _tasks.size()) {
+                break;
+            }
+
+            runTask(worker, _tasks[taskIdx], filenames, cpattern);
+        }
+
+        worker.reader->close();
+        worker.openFile = NO_FILE;
+    };
+
+    _pool->run(_numOfThreads - 1, threadFunc);
+    threadFunc(_numOfThreads - 1);
+    _pool->wait();
+
+    size_t result = 0;
+    for(auto counter: _counts) {
+        result += counter;
+    }
+    return result;
+}
+
+} // namespace fwc
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+
+#include "noncopyable.h"
+#include "utils.h"
+#include "linesblock.h"
+#include "wildcard.h"
+#include "filereader.h"
+#include "threadpool.h"
+
+namespace fwc {
+
+/*
+This class processes a lot of files at once. Files are turned into tasks:
+a big file is split into byte ranges of about 'chunkSize' bytes (if its
+reader supports seeking, otherwise it's one task) and small files are packed
+together until a pack has about 'chunkSize' bytes. Threads take tasks one by one from a shared
+counter, the biggest tasks go first. Each thread has its own reader and
+lines block which are reused for all its tasks.
+*/
+
+class BatchProcessor final: private noncopyable
+{
+public:
+
+    using FileList      = std::vector<std::string>;
+    using ReaderFactory = std::function<std::unique_ptr<FileReader>()>;
+
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 32*1024*1024;
+
+    BatchProcessor(size_t numOfThreads, BlockLimits limits, const ReaderFactory& factory,
+                    size_t chunkSize = DEFAULT_CHUNK_SIZE, ThreadPool* pool = nullptr);
+
+    // Returns total number of found lines in all files,
+    // numbers for each file are available with 'counts'
+    size_t execute(const FileList& filenames, const CompiledPattern& cpattern);
+
+    size_t execute(const FileList& filenames,
+                    const WildcardMatch& wcmatch, const std::string& pattern) {
+        return execute(filenames, *wcmatch.compile(pattern));
+    }
+
+    // numbers of found lines for each file in the order of the last executed list
+    [[nodiscard]]
+    const std::vector<size_t>& counts() const noexcept { return _counts; }
+
+    // Regular files from the directory tree whose names match
+    // the glob (fnmatch) pattern, they are sorted by path
+    [[nodiscard]]
+    static FileList listFiles(const std::string& dirname, const std::string& glob,
+                                bool recursive = true);
+
+private:
+
+    // files [firstFile, lastFile) or range [begin, end) of one file
+    struct Task
+    {
+        size_t firstFile;
+        size_t lastFile;
+        size_t begin;
+        size_t end;
+        size_t bytes;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Worker
+    {
+        std::unique_ptr<FileReader> reader;
+        LinesBlockPtr               block { nullptr };
+        size_t                      openFile;
+    };
+
+    void makeTasks(const FileList& filenames);
+    void runTask(Worker& worker, const Task& task, const FileList& filenames,
+                                            const CompiledPattern& cpattern);
+
+    std::vector<Worker>         _workers;
+    std::vector<Task>           _tasks;
+    std::vector<size_t>         _sizes;
+    std::vector<size_t>         _counts;
+    std::atomic<size_t>         _nextTask { 0 };
+    LinesBlockPool              _blocksPool;
+    const size_t                _chunkSize;
+    const size_t                _numOfThreads;
+    std::unique_ptr<ThreadPool> _ownPool;
+    ThreadPool*                 _pool;
+};
+
+} // namespace fwc
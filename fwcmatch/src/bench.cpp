@@ -3,40 +3,97 @@
 #include <cstddef>
 #include <cstdlib>
 #include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <thread>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <benchmark/benchmark.h>
+#include <zlib.h>
 
 #include "fgetsreader.h"
 #include "mmapreader.h"
 #include "fstreamreader.h"
+#include "uringreader.h"
+#include "wmmapreader.h"
+#include "blockreader.h"
+#include "compressedreader.h"
+#include "newlineindex.h"
 #include "mywildcard.h"
-#include "fnmatchwildcard.h"
+#include "simdwildcard.h"
+#include "globwildcard.h"
 #include "regexwildcard.h"
+#include "regexmatch.h"
+#include "dfawildcard.h"
 #include "seqproc.h"
+#include "searchproc.h"
 #include "mtcondvarproc.h"
 #include "mtcondvarproc2.h"
 #include "mtlockfreeproc.h"
 #include "mtsemproc.h"
 #include "mtmpmcproc.h"
+#include "mtstealproc.h"
 #include "mtlockreadproc.h"
+#include "mmapchunkproc.h"
+#include "followproc.h"
+#include "batchproc.h"
+#include "multipattern.h"
+#include "linesink.h"
+#include "utils.h"
 
 using namespace fwc;
 
 static std::string benchFileName;
 static std::string benchPattern;
+static std::string benchSmallFileName;
+static std::string benchSkewedFileName;
+static std::string benchBatchDir;
+static std::string benchBatchGlob = "*";
+static std::string benchCompressedFileName;
+
+// Reset peak resident memory of the process (VmHWM), linux 4.0+
+static void resetPeakRSS() {
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+// Peak resident memory of the process (VmHWM) in MB
+static double peakRSS() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while(std::getline(status, line)) {
+        if(line.rfind("VmHWM:", 0) == 0) {
+            return std::stod(line.substr(6)) / 1024;
+        }
+    }
+    return 0;
+}
+
+// blocks are limited by a byte budget in KB, the number of lines adapts to it
+static BlockLimits budgetLimits(int64_t budgetKB) {
+    return BlockLimits::ofBytes(budgetKB * 1024);
+}
 
 template<typename FReader, typename WildcardMatch>
 void BM_Sequential(benchmark::State& state) {
 
-    const size_t maxLines = state.range(0);
+    const auto limits = budgetLimits(state.range(0));
 
     auto freader   = FReader();
     auto wcmatch   = WildcardMatch();
-    auto processor = SequentialProcessor(maxLines, freader.needsBuffer());
+    auto processor = SequentialProcessor(limits, freader.needsBuffer());
+
+    auto cpattern  = wcmatch.compile(benchPattern);
 
     size_t found = 0;
     for (auto _ : state) {
-        found = processor.execute(freader, benchFileName, wcmatch, benchPattern);
+        found = processor.execute(freader, benchFileName, *cpattern);
         benchmark::DoNotOptimize(found);
     }
 
@@ -45,11 +102,12 @@ void BM_Sequential(benchmark::State& state) {
 
 static void genSequentialArguments(benchmark::internal::Benchmark* b) {
     b
-    ->Arg(1)
+    // byte budget of a block in KB
     ->Arg(4)
     ->Arg(16)
-    ->Arg(32)
-    ->ArgNames({"mlines", })
+    ->Arg(64)
+    ->Arg(256)
+    ->ArgNames({"kbytes", })
     //->Iterations(2)
     ->Unit(benchmark::kMillisecond)
     ->UseRealTime();
@@ -64,20 +122,270 @@ BENCHMARK(BM_Sequential<FStreamReader, MyWildcardMatch>)
 BENCHMARK(BM_Sequential<MMapReader, MyWildcardMatch>)
     ->Apply(genSequentialArguments);
 
+BENCHMARK(BM_Sequential<UringReader, MyWildcardMatch>)
+    ->Apply(genSequentialArguments);
+
+BENCHMARK(BM_Sequential<WMMapReader, MyWildcardMatch>)
+    ->Apply(genSequentialArguments);
+
+BENCHMARK(BM_Sequential<FGetsReader, SIMDWildcardMatch>)
+    ->Apply(genSequentialArguments);
+
+BENCHMARK(BM_Sequential<FStreamReader, SIMDWildcardMatch>)
+    ->Apply(genSequentialArguments);
+
+BENCHMARK(BM_Sequential<MMapReader, SIMDWildcardMatch>)
+    ->Apply(genSequentialArguments);
+
+BENCHMARK(BM_Sequential<UringReader, SIMDWildcardMatch>)
+    ->Apply(genSequentialArguments);
+
+BENCHMARK(BM_Sequential<BlockReader, MyWildcardMatch>)
+    ->Apply(genSequentialArguments);
+
+BENCHMARK(BM_Sequential<BlockReader, SIMDWildcardMatch>)
+    ->Apply(genSequentialArguments);
+
+BENCHMARK(BM_Sequential<MMapReader, DFAWildcardMatch>)
+    ->Apply(genSequentialArguments);
+
+BENCHMARK(BM_Sequential<FGetsReader, DFAWildcardMatch>)
+    ->Apply(genSequentialArguments);
+
+// Patterns which are hard for a matcher with search of segments, the first
+// one is BENCH_PATTERN for comparison
+static const std::string& adversarialPattern(size_t idx) {
+
+    static const std::string patterns[] = {
+        "",
+        "*a*a*a*b",
+        "*e????????d*",
+        "*o?e?o?e?d*",
+        "*?a?*?e?*?d?*x",
+    };
+
+    return idx ? patterns[idx] : benchPattern;
+}
+
+template<typename WildcardMatch>
+void BM_Adversarial(benchmark::State& state) {
+
+    auto freader   = MMapReader();
+    auto wcmatch   = WildcardMatch();
+    auto processor = SequentialProcessor(budgetLimits(256), freader.needsBuffer());
+
+    auto cpattern  = wcmatch.compile(adversarialPattern(state.range(0)));
+
+    size_t found = 0;
+    for (auto _ : state) {
+        found = processor.execute(freader, benchFileName, *cpattern);
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.counters["Count"] = found;
+}
+
+static void genAdversarialArguments(benchmark::internal::Benchmark* b) {
+    b
+    ->DenseRange(0, 4)
+    ->ArgNames({"pattern", })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+}
+
+BENCHMARK(BM_Adversarial<MyWildcardMatch>)
+    ->Apply(genAdversarialArguments);
+
+BENCHMARK(BM_Adversarial<SIMDWildcardMatch>)
+    ->Apply(genAdversarialArguments);
+
+// Patterns with brackets and escapes, each one is matched with and without
+// the case
+static const std::string& syntaxPattern(size_t idx) {
+
+    static const std::string patterns[] = {
+        "*[Ff]ailed*",
+        "*\\[error\\]*",
+        "*[0-9]?[!a-z]*",
+        "*FAILED*",
+    };
+
+    return patterns[idx];
+}
+
+template<typename WildcardMatch>
+void BM_Syntax(benchmark::State& state) {
+
+    auto freader   = MMapReader();
+    auto wcmatch   = WildcardMatch(state.range(1) != 0);
+    auto processor = SequentialProcessor(budgetLimits(256), freader.needsBuffer());
+
+    auto cpattern  = wcmatch.compile(syntaxPattern(state.range(0)));
+
+    size_t found = 0;
+    for (auto _ : state) {
+        found = processor.execute(freader, benchFileName, *cpattern);
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.counters["Count"] = found;
+}
+
+static void genSyntaxArguments(benchmark::internal::Benchmark* b) {
+    b
+    ->ArgsProduct({ benchmark::CreateDenseRange(0, 3, 1), { 0, 1 } })
+    ->ArgNames({"pattern", "nocase" })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+}
+
+BENCHMARK(BM_Syntax<MyWildcardMatch>)
+    ->Apply(genSyntaxArguments);
+
+BENCHMARK(BM_Syntax<SIMDWildcardMatch>)
+    ->Apply(genSyntaxArguments);
+
+BENCHMARK(BM_Adversarial<DFAWildcardMatch>)
+    ->Apply(genAdversarialArguments);
+
+// BlockReader with different chunk sizes, with and without copying of lines
+void BM_BlockReader(benchmark::State& state) {
+
+    const size_t maxLines  = state.range(0);
+    const bool   zeroCopy  = state.range(1);
+    const size_t chunkSize = state.range(2) * 1024 * 1024;
+
+    auto freader   = BlockReader(chunkSize, zeroCopy);
+    auto wcmatch   = MyWildcardMatch();
+    auto processor = SequentialProcessor(maxLines, freader.needsBuffer());
+
+    auto cpattern  = wcmatch.compile(benchPattern);
+
+    size_t found = 0;
+    for (auto _ : state) {
+        found = processor.execute(freader, benchFileName, *cpattern);
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.counters["Count"] = found;
+}
+
+BENCHMARK(BM_BlockReader)
+    // maxLines, zeroCopy, chunkSize in MB
+    ->Args({16, 0, 1})
+    ->Args({16, 0, 4})
+    ->Args({16, 0, 16})
+    ->Args({16, 1, 1})
+    ->Args({16, 1, 4})
+    ->Args({16, 1, 16})
+    ->Args({32, 1, 4})
+
+    ->ArgNames({"mlines", "zcopy", "chunk" })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Drop the file from the page cache so it's read from the disk
+static void dropFromPageCache(const std::string& fileName) {
+    const int fd = ::open(fileName.c_str(), O_RDONLY);
+    if(fd >= 0) {
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+}
+
+// Size of the file part which is in the page cache in MB
+static double cachedSize(const std::string& fileName) {
+    const int fd = ::open(fileName.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return 0;
+    }
+
+    struct stat sb;
+    void* addr = MAP_FAILED;
+    if(::fstat(fd, &sb) == 0 && sb.st_size > 0) {
+        addr = ::mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if(MAP_FAILED == addr) {
+        return 0;
+    }
+
+    const size_t pageSize = ::sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> pages((sb.st_size + pageSize - 1) / pageSize);
+    size_t cached = 0;
+    if(::mincore(addr, sb.st_size, pages.data()) == 0) {
+        cached = std::count_if(pages.begin(), pages.end(),
+                                    [](unsigned char page) { return page & 1; });
+    }
+    ::munmap(addr, sb.st_size);
+
+    return static_cast<double>(cached * pageSize) / (1024 * 1024);
+}
+
+// Scanning of a file which isn't in the page cache,
+// CachedMB shows how much of the page cache the file takes after scanning
+void BM_ColdCache(benchmark::State& state) {
+
+    const auto   cachePolicy = static_cast<BlockReader::CachePolicy>(state.range(0));
+    const size_t chunkSize   = state.range(1) * 1024 * 1024;
+
+    auto freader   = BlockReader(chunkSize, true, cachePolicy);
+    auto wcmatch   = MyWildcardMatch();
+    auto processor = SequentialProcessor(32, freader.needsBuffer());
+
+    auto cpattern  = wcmatch.compile(benchPattern);
+
+    size_t found = 0;
+    double cached = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        dropFromPageCache(benchFileName);
+        state.ResumeTiming();
+
+        found = processor.execute(freader, benchFileName, *cpattern);
+        benchmark::DoNotOptimize(found);
+
+        state.PauseTiming();
+        cached = cachedSize(benchFileName);
+        state.ResumeTiming();
+    }
+
+    state.counters["Count"]    = found;
+    state.counters["CachedMB"] = cached;
+    state.counters["DirectIO"] = freader.usesDirectIO();
+    state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(benchFileName));
+}
+
+BENCHMARK(BM_ColdCache)
+    // cache policy (0 - keep, 1 - O_DIRECT, 2 - drop), chunkSize in MB
+    ->Args({0, 4})
+    ->Args({1, 1})
+    ->Args({1, 4})
+    ->Args({1, 16})
+    ->Args({2, 4})
+
+    ->ArgNames({"cache", "chunk" })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
 ///////////////////////////////////////////////////////////
+// GlobMatch has fnmatch semantics without copying of lines to add '\0'
+// (FNMatch does it)
 
-BENCHMARK(BM_Sequential<FGetsReader, FNMatch>)
+BENCHMARK(BM_Sequential<FGetsReader, GlobMatch>)
     ->Apply(genSequentialArguments);
 
-BENCHMARK(BM_Sequential<FStreamReader, FNMatch>)
+BENCHMARK(BM_Sequential<FStreamReader, GlobMatch>)
     ->Apply(genSequentialArguments);
 
-BENCHMARK(BM_Sequential<MMapReader, FNMatch>)
+BENCHMARK(BM_Sequential<MMapReader, GlobMatch>)
     ->Apply(genSequentialArguments);
 
 ///////////////////////////////////////////////////////////
-// C++ std::regex is very slow
-/*
+// Wildcards through regular expressions of RegexMatch (C++ std::regex
+// was very slow here)
+
 BENCHMARK(BM_Sequential<FGetsReader, REMatch>)
     ->Apply(genSequentialArguments);
 
@@ -86,27 +394,181 @@ BENCHMARK(BM_Sequential<FStreamReader, REMatch>)
 
 BENCHMARK(BM_Sequential<MMapReader, REMatch>)
     ->Apply(genSequentialArguments);
-//*/
+
+// Regular expressions which can't be wildcards, the first ones have
+// a required literal for the prefilter
+static const std::string& regexPattern(size_t idx) {
+
+    static const std::string patterns[] = {
+        "failed",
+        "(copied|deleted) .*file",
+        "[Ff]ailed|\\[error\\]",
+        "^[a-z]+ [A-Z]{2,} ",
+    };
+
+    return patterns[idx];
+}
+
+template<typename WildcardMatch>
+void BM_Regex(benchmark::State& state) {
+
+    auto freader   = MMapReader();
+    auto wcmatch   = WildcardMatch();
+    auto processor = SequentialProcessor(budgetLimits(256), freader.needsBuffer());
+
+    auto cpattern  = wcmatch.compile(regexPattern(state.range(0)));
+
+    size_t found = 0;
+    for (auto _ : state) {
+        found = processor.execute(freader, benchFileName, *cpattern);
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.counters["Count"] = found;
+}
+
+BENCHMARK(BM_Regex<RegexMatch>)
+    ->DenseRange(0, 3)
+    ->ArgNames({"pattern", })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+template<typename WildcardMatch>
+void BM_SearchFirst(benchmark::State& state) {
+
+    auto freader   = MMapReader();
+    auto wcmatch   = WildcardMatch();
+    auto processor = SearchFirstProcessor();
+
+    auto cpattern  = wcmatch.compile(benchPattern);
+
+    size_t found = 0;
+    for (auto _ : state) {
+        found = processor.execute(freader, benchFileName, *cpattern);
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.counters["Count"] = found;
+}
+
+BENCHMARK(BM_SearchFirst<MyWildcardMatch>)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_SearchFirst<SIMDWildcardMatch>)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// The first 'num' patterns from BENCH_PATTERN and typical words of logs
+static MultiPattern::PatternList multiPatterns(size_t num) {
+
+    static const char* words[] = {
+        "timeout", "OOM", "error", "deleted", "copied", "update", "sync",
+        "Failed", "warning", "refused", "denied", "panic", "crash", "abort",
+        "retry", "closed", "reset", "expired", "invalid", "missing",
+        "overflow", "underflow", "corrupt", "mismatch", "rejected", "fatal",
+        "critical", "unreachable", "throttled", "evicted", "killed", "stuck",
+        "deadlock", "leak", "segfault", "exception", "unavailable", "lost",
+        "dropped", "skipped", "stale", "conflict", "locked", "blocked",
+        "forbidden", "unauthorized", "disconnected", "restart", "shutdown",
+    };
+
+    MultiPattern::PatternList patterns { benchPattern };
+    for(size_t i = 0; patterns.size() < num; ++i) {
+        patterns.push_back(std::string("*") + words[i % std::size(words)] + "*");
+    }
+    patterns.resize(num);
+
+    return patterns;
+}
+
+// Count lines for each of a lot of patterns: one execution per pattern
+// or one execution with MultiPatternCounter
+template<typename Processor>
+void BM_MultiPattern(benchmark::State& state) {
+
+    const size_t numOfPatterns = state.range(0);
+    const bool   onePass       = state.range(1);
+
+    auto freader   = MMapReader();
+    auto wcmatch   = MyWildcardMatch();
+    auto processor = [&]() {
+        if constexpr (std::is_same_v<Processor, SequentialProcessor>) {
+            return Processor(budgetLimits(256), freader.needsBuffer());
+        }
+        else {
+            return Processor(8, 3, budgetLimits(256), freader.needsBuffer());
+        }
+    }();
+
+    auto patterns = MultiPattern(wcmatch, multiPatterns(numOfPatterns));
+    auto counter  = MultiPatternCounter(patterns);
+
+    size_t found = 0;
+    for (auto _ : state) {
+        found = 0;
+        if(onePass) {
+            counter.reset();
+            processor.execute(freader, benchFileName, counter);
+            for(auto count: counter.counts()) {
+                found += count;
+            }
+        }
+        else {
+            for(size_t i = 0; i < patterns.size(); ++i) {
+                found += processor.execute(freader, benchFileName, patterns.pattern(i));
+            }
+        }
+        benchmark::DoNotOptimize(found);
+    }
+
+    // sum of numbers of lines for each pattern
+    state.counters["Count"] = found;
+}
+
+static void genMultiPatternArguments(benchmark::internal::Benchmark* b) {
+    b
+    // number of patterns, one pass
+    ->Args({1,  0})
+    ->Args({1,  1})
+    ->Args({10, 0})
+    ->Args({10, 1})
+    ->Args({50, 0})
+    ->Args({50, 1})
+
+    ->ArgNames({"patterns", "onepass" })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+}
+
+BENCHMARK(BM_MultiPattern<SequentialProcessor>)
+    ->Apply(genMultiPatternArguments);
+
+BENCHMARK(BM_MultiPattern<MTCondVarProcessor>)
+    ->Apply(genMultiPatternArguments);
 
 template<typename Processor, typename FReader, typename WildcardMatch>
-void MTProdConsTempl(benchmark::State& state) {
+void MTProdConsTempl(benchmark::State& state,
+                        const std::string& fileName = benchFileName) {
 
     const size_t queueSize     = state.range(0);
     const size_t numOfThreads  = state.range(1);
-    const size_t maxLines      = state.range(2);
+    const auto   limits        = budgetLimits(state.range(2));
 
     assert(queueSize > 0);
     assert(numOfThreads > 1);
-    assert(maxLines > 0);
+    assert(limits.maxBytes > 0);
 
     auto freader   = FReader();
     auto wcmatch   = WildcardMatch();
     auto processor = Processor(queueSize, numOfThreads - 1,
-                                    maxLines, freader.needsBuffer());
+                                    limits, freader.needsBuffer());
+
+    auto cpattern  = wcmatch.compile(benchPattern);
 
     size_t found = 0;
     for (auto _ : state) {
-        found = processor.execute(freader, benchFileName, wcmatch, benchPattern);
+        found = processor.execute(freader, fileName, *cpattern);
         benchmark::DoNotOptimize(found);
     }
 
@@ -138,30 +600,37 @@ void BM_MTMPMC(benchmark::State& state) {
     MTProdConsTempl<MPMCProcessor, FReader, WildcardMatch>(state);
 }
 
+template<typename FReader, typename WildcardMatch>
+void BM_MTWorkStealing(benchmark::State& state) {
+    MTProdConsTempl<MTWorkStealingProcessor, FReader, WildcardMatch>(state);
+}
+
 static void genMultithreadingArguments(benchmark::internal::Benchmark* b) {
     b
-    // queueSize, numOfThreads, maxLines
+    // queueSize, numOfThreads, byte budget of a block in KB
 
     ->Args({2,   2, 16})
-    ->Args({2,   2, 96})
-    ->Args({8,   2, 96})
-    ->Args({32,  2, 96})
-
-    ->Args({2,   4, 96})
-    ->Args({4,   4, 96})
-    ->Args({8,   4, 96})
-    ->Args({16,  4, 96})
-    ->Args({32,  4, 96})
-    ->Args({128, 4, 96})
+    ->Args({2,   2, 64})
+    ->Args({8,   2, 64})
+    ->Args({32,  2, 64})
+
+    ->Args({2,   4, 64})
+    ->Args({4,   4, 64})
+    ->Args({8,   4, 16})
+    ->Args({8,   4, 64})
+    ->Args({16,  4, 64})
+    ->Args({32,  4, 64})
+    ->Args({128, 4, 64})
     ->Args({4,   4, 256})
     ->Args({8,   4, 256})
     ->Args({16,  4, 256})
+    ->Args({8,   4, 1024})
 
     ->Args({8,   8, 256})
     ->Args({16,  8, 256})
-    //->Args({16,  8, 512})
+    //->Args({16,  8, 1024})
 
-    ->ArgNames({"qsize", "threads", "mlines" })
+    ->ArgNames({"qsize", "threads", "kbytes" })
     //->Iterations(2)
     ->Unit(benchmark::kMillisecond)
     ->MeasureProcessCPUTime()
@@ -177,6 +646,12 @@ BENCHMARK(BM_MTCondVar<FStreamReader, MyWildcardMatch>)
 BENCHMARK(BM_MTCondVar<MMapReader, MyWildcardMatch>)
     ->Apply(genMultithreadingArguments);
 
+BENCHMARK(BM_MTCondVar<UringReader, MyWildcardMatch>)
+    ->Apply(genMultithreadingArguments);
+
+BENCHMARK(BM_MTCondVar<BlockReader, MyWildcardMatch>)
+    ->Apply(genMultithreadingArguments);
+
 BENCHMARK(BM_MTCondVar2<FGetsReader, MyWildcardMatch>)
     ->Apply(genMultithreadingArguments);
 
@@ -195,6 +670,12 @@ BENCHMARK(BM_MTLockFree<FStreamReader, MyWildcardMatch>)
 BENCHMARK(BM_MTLockFree<MMapReader, MyWildcardMatch>)
     ->Apply(genMultithreadingArguments);
 
+BENCHMARK(BM_MTLockFree<UringReader, MyWildcardMatch>)
+    ->Apply(genMultithreadingArguments);
+
+BENCHMARK(BM_MTLockFree<BlockReader, MyWildcardMatch>)
+    ->Apply(genMultithreadingArguments);
+
 BENCHMARK(BM_MTSem<FGetsReader, MyWildcardMatch>)
     ->Apply(genMultithreadingArguments);
 
@@ -213,63 +694,839 @@ BENCHMARK(BM_MTMPMC<FStreamReader, MyWildcardMatch>)
 BENCHMARK(BM_MTMPMC<MMapReader, MyWildcardMatch>)
     ->Apply(genMultithreadingArguments);
 
-template<typename FReader, typename WildcardMatch>
-void BM_MTLockRead(benchmark::State& state) {
+BENCHMARK(BM_MTMPMC<UringReader, MyWildcardMatch>)
+    ->Apply(genMultithreadingArguments);
 
-    const size_t numOfThreads  = state.range(0);
-    const size_t maxLines      = state.range(1);
+BENCHMARK(BM_MTMPMC<BlockReader, MyWildcardMatch>)
+    ->Apply(genMultithreadingArguments);
+
+BENCHMARK(BM_MTWorkStealing<FGetsReader, MyWildcardMatch>)
+    ->Apply(genMultithreadingArguments);
+
+BENCHMARK(BM_MTWorkStealing<FStreamReader, MyWildcardMatch>)
+    ->Apply(genMultithreadingArguments);
+
+BENCHMARK(BM_MTWorkStealing<MMapReader, MyWildcardMatch>)
+    ->Apply(genMultithreadingArguments);
+
+// The same with a skewed file: mixed line lengths and regions
+// with many matched lines, see makeSkewedFile()
+template<typename Processor>
+void BM_Skewed(benchmark::State& state) {
+
+    if(benchSkewedFileName.empty()) {
+        state.SkipWithError("Environment variable BENCH_SKEWED_FILENAME is not set");
+        return;
+    }
+
+    MTProdConsTempl<Processor, MMapReader, MyWildcardMatch>(state, benchSkewedFileName);
+}
+
+BENCHMARK(BM_Skewed<MTLockFreeProcessor>)
+    ->Apply(genMultithreadingArguments);
+
+BENCHMARK(BM_Skewed<MPMCProcessor>)
+    ->Apply(genMultithreadingArguments);
+
+BENCHMARK(BM_Skewed<MTWorkStealingProcessor>)
+    ->Apply(genMultithreadingArguments);
+
+// Adaptive mode tunes the byte budget (up to the given one) and the number of
+// consumers during the first MBs, it is compared with static configurations.
+// BudgetKB and Consumers show the tuned values.
+template<typename FReader>
+void BM_Adaptive(benchmark::State& state) {
+
+    const size_t queueSize     = state.range(0);
+    const size_t numOfThreads  = state.range(1);
+    const auto   limits        = budgetLimits(state.range(2));
+    const bool   adaptive      = state.range(3);
 
     auto freader   = FReader();
-    auto wcmatch   = WildcardMatch();
-    auto processor = MTLockReadProcessor(numOfThreads, maxLines, freader.needsBuffer());
+    auto wcmatch   = MyWildcardMatch();
+    auto processor = MTCondVarProcessor(queueSize, numOfThreads - 1,
+                                            limits, freader.needsBuffer());
+    processor.setAdaptive(adaptive);
+
+    auto cpattern  = wcmatch.compile(benchPattern);
 
     size_t found = 0;
     for (auto _ : state) {
-        found = processor.execute(freader, benchFileName, wcmatch, benchPattern);
+        found = processor.execute(freader, benchFileName, *cpattern);
         benchmark::DoNotOptimize(found);
     }
 
     state.counters["Count"] = found;
+    if(auto tuner = processor.autotuner(); tuner && tuner->tuned()) {
+        state.counters["BudgetKB"]  = tuner->budget() / 1024;
+        state.counters["Consumers"] = tuner->activeConsumers();
+    }
 }
 
-static void genMultithreading2Arguments(benchmark::internal::Benchmark* b) {
+static void genAdaptiveArguments(benchmark::internal::Benchmark* b) {
     b
-    // numOfThreads, maxLines
-
-    ->Args({2, 96})
-    ->Args({2, 256})
-    ->Args({2, 512})
-
-    ->Args({4, 96})
-    ->Args({4, 256})
-    ->Args({4, 512})
-
-    ->Args({8, 96})
-    ->Args({8, 256})
-    ->Args({8, 512})
-
-    ->ArgNames({"threads", "mlines" })
+    // queueSize, numOfThreads, byte budget of a block in KB, adaptive mode
+    ->Args({8, 4, 16,   0})
+    ->Args({8, 4, 64,   0})
+    ->Args({8, 4, 256,  0})
+    ->Args({8, 4, 1024, 0})
+    ->Args({8, 4, 1024, 1})
+
+    ->Args({8, 8, 16,   0})
+    ->Args({8, 8, 64,   0})
+    ->Args({8, 8, 256,  0})
+    ->Args({8, 8, 1024, 0})
+    ->Args({8, 8, 1024, 1})
+
+    ->ArgNames({"qsize", "threads", "kbytes", "adaptive" })
     ->Unit(benchmark::kMillisecond)
     ->MeasureProcessCPUTime()
     ->UseRealTime();
 }
 
-/*
-BENCHMARK(BM_MTLockRead<FGetsReader, MyWildcardMatch>)
-    ->Apply(genMultithreading2Arguments);
-*/
+BENCHMARK(BM_Adaptive<FGetsReader>)
+    ->Apply(genAdaptiveArguments);
 
-BENCHMARK(BM_MTLockRead<FStreamReader, MyWildcardMatch>)
-    ->Apply(genMultithreading2Arguments);
+BENCHMARK(BM_Adaptive<MMapReader>)
+    ->Apply(genAdaptiveArguments);
 
-BENCHMARK(BM_MTLockRead<MMapReader, MyWildcardMatch>)
-    ->Apply(genMultithreading2Arguments);
+// Compressed file, it's decompressed on separate threads of the reader
+void BM_CompressedSequential(benchmark::State& state) {
 
-static bool handleEnvVars() {
+    if(benchCompressedFileName.empty()) {
+        state.SkipWithError("Environment variable BENCH_COMPRESSED_FILENAME is not set");
+        return;
+    }
 
-    const char* envvar = nullptr;
+    const auto limits = budgetLimits(state.range(0));
 
-    auto printErr = [](const std::string& msg) {
+    auto freader   = CompressedReader();
+    auto wcmatch   = MyWildcardMatch();
+    auto processor = SequentialProcessor(limits, freader.needsBuffer());
+
+    auto cpattern  = wcmatch.compile(benchPattern);
+
+    size_t found = 0;
+    for (auto _ : state) {
+        found = processor.execute(freader, benchCompressedFileName, *cpattern);
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.counters["Count"] = found;
+    state.counters["Threads"] = freader.numOfStreams();
+}
+
+BENCHMARK(BM_CompressedSequential)
+    ->Apply(genSequentialArguments);
+
+template<typename Processor>
+void BM_Compressed(benchmark::State& state) {
+
+    if(benchCompressedFileName.empty()) {
+        state.SkipWithError("Environment variable BENCH_COMPRESSED_FILENAME is not set");
+        return;
+    }
+
+    MTProdConsTempl<Processor, CompressedReader, MyWildcardMatch>(state, benchCompressedFileName);
+}
+
+BENCHMARK(BM_Compressed<MTCondVarProcessor>)
+    ->Apply(genMultithreadingArguments);
+
+BENCHMARK(BM_Compressed<MTLockFreeProcessor>)
+    ->Apply(genMultithreadingArguments);
+
+template<typename FReader, typename WildcardMatch>
+void BM_MTLockRead(benchmark::State& state) {
+
+    const size_t numOfThreads  = state.range(0);
+    const auto   limits        = budgetLimits(state.range(1));
+
+    auto freader   = FReader();
+    auto wcmatch   = WildcardMatch();
+    auto processor = MTLockReadProcessor(numOfThreads, limits, freader.needsBuffer());
+
+    auto cpattern  = wcmatch.compile(benchPattern);
+
+    size_t found = 0;
+    for (auto _ : state) {
+        found = processor.execute(freader, benchFileName, *cpattern);
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.counters["Count"] = found;
+}
+
+static void genMultithreading2Arguments(benchmark::internal::Benchmark* b) {
+    b
+    // numOfThreads, byte budget of a block in KB
+
+    ->Args({2, 16})
+    ->Args({2, 64})
+    ->Args({2, 256})
+
+    ->Args({4, 16})
+    ->Args({4, 64})
+    ->Args({4, 256})
+
+    ->Args({8, 16})
+    ->Args({8, 64})
+    ->Args({8, 256})
+
+    ->ArgNames({"threads", "kbytes" })
+    ->Unit(benchmark::kMillisecond)
+    ->MeasureProcessCPUTime()
+    ->UseRealTime();
+}
+
+/*
+BENCHMARK(BM_MTLockRead<FGetsReader, MyWildcardMatch>)
+    ->Apply(genMultithreading2Arguments);
+*/
+
+BENCHMARK(BM_MTLockRead<FStreamReader, MyWildcardMatch>)
+    ->Apply(genMultithreading2Arguments);
+
+BENCHMARK(BM_MTLockRead<MMapReader, MyWildcardMatch>)
+    ->Apply(genMultithreading2Arguments);
+
+// Many short jobs with small files: the processor is created once and its
+// threads are reused or it is created for each file and so cost of
+// starting threads is measured.
+template<typename Processor, bool ReuseProcessor>
+void MTSmallFileTempl(benchmark::State& state) {
+
+    if(benchSmallFileName.empty()) {
+        state.SkipWithError("Environment variable BENCH_SMALL_FILENAME is not set");
+        return;
+    }
+
+    const size_t queueSize     = state.range(0);
+    const size_t numOfThreads  = state.range(1);
+    const size_t maxLines      = state.range(2);
+
+    auto freader   = MMapReader();
+    auto wcmatch   = MyWildcardMatch();
+    auto cpattern  = wcmatch.compile(benchPattern);
+
+    auto makeProcessor = [&]() {
+        return std::make_unique<Processor>(queueSize, numOfThreads - 1,
+                                            maxLines, freader.needsBuffer());
+    };
+
+    auto processor = makeProcessor();
+
+    size_t found = 0;
+    for (auto _ : state) {
+        if(!ReuseProcessor) {
+            processor = makeProcessor();
+        }
+        found = processor->execute(freader, benchSmallFileName, *cpattern);
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.counters["Count"] = found;
+}
+
+template<typename Processor>
+void BM_SmallFileReusedProc(benchmark::State& state) {
+    MTSmallFileTempl<Processor, true>(state);
+}
+
+template<typename Processor>
+void BM_SmallFileNewProc(benchmark::State& state) {
+    MTSmallFileTempl<Processor, false>(state);
+}
+
+static void genSmallFileArguments(benchmark::internal::Benchmark* b) {
+    b
+    // queueSize, numOfThreads, maxLines
+
+    ->Args({8, 2, 96})
+    ->Args({8, 4, 96})
+
+    ->ArgNames({"qsize", "threads", "mlines" })
+    ->Unit(benchmark::kMicrosecond)
+    ->MeasureProcessCPUTime()
+    ->UseRealTime();
+}
+
+BENCHMARK(BM_SmallFileReusedProc<MTCondVarProcessor>)
+    ->Apply(genSmallFileArguments);
+
+BENCHMARK(BM_SmallFileNewProc<MTCondVarProcessor>)
+    ->Apply(genSmallFileArguments);
+
+BENCHMARK(BM_SmallFileReusedProc<MTSemProcessor>)
+    ->Apply(genSmallFileArguments);
+
+BENCHMARK(BM_SmallFileNewProc<MTSemProcessor>)
+    ->Apply(genSmallFileArguments);
+
+BENCHMARK(BM_SmallFileReusedProc<MPMCProcessor>)
+    ->Apply(genSmallFileArguments);
+
+BENCHMARK(BM_SmallFileNewProc<MPMCProcessor>)
+    ->Apply(genSmallFileArguments);
+
+// The bench file is appended to a new file by chunks which split lines
+// at random places while the follow processor reads it. It measures time
+// until all lines are processed.
+template<typename FReader>
+void BM_Follow(benchmark::State& state) {
+
+    const size_t maxLines  = state.range(0);
+    const size_t chunkSize = state.range(1) * 1024;
+
+    std::ifstream source(benchFileName, std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(source)),
+                                std::istreambuf_iterator<char>());
+    // the last line without newline is never complete in follow mode
+    const size_t expectedLines = std::count(content.begin(), content.end(), '\n');
+
+    const auto followFileName = (std::filesystem::temp_directory_path() /
+                                    "fwcmatch-follow.txt").string();
+
+    auto freader   = FReader();
+    auto wcmatch   = MyWildcardMatch();
+    auto processor = FollowProcessor(maxLines, freader.needsBuffer());
+
+    auto cpattern  = wcmatch.compile(benchPattern);
+
+    auto progress = [&](size_t, size_t linesRead) {
+        return linesRead < expectedLines;
+    };
+
+    size_t found = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::ofstream(followFileName, std::ios::binary | std::ios::trunc);
+        state.ResumeTiming();
+
+        std::thread writer([&]() {
+            std::mt19937 rng(12345);
+            FILE* file = fopen(followFileName.c_str(), "ab");
+            for(size_t pos = 0; pos < content.size(); ) {
+                const size_t size = std::min(content.size() - pos, rng() % chunkSize + 1);
+                fwrite(content.data() + pos, 1, size, file);
+                fflush(file);
+                pos += size;
+            }
+            fclose(file);
+        });
+
+        found = processor.execute(freader, followFileName, *cpattern, progress);
+        writer.join();
+
+        benchmark::DoNotOptimize(found);
+    }
+
+    std::filesystem::remove(followFileName);
+    state.counters["Count"] = found;
+}
+
+static void genFollowArguments(benchmark::internal::Benchmark* b) {
+    b
+    // maxLines, max size of appended chunk in KB
+    ->Args({32, 4})
+    ->Args({32, 256})
+    ->ArgNames({"mlines", "chunk" })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+}
+
+BENCHMARK(BM_Follow<FGetsReader>)
+    ->Apply(genFollowArguments);
+
+BENCHMARK(BM_Follow<MMapReader>)
+    ->Apply(genFollowArguments);
+
+template<typename WildcardMatch>
+void BM_MMapChunked(benchmark::State& state) {
+
+    const size_t numOfThreads  = state.range(0);
+
+    auto freader   = MMapReader();
+    auto wcmatch   = WildcardMatch();
+    auto processor = MMapChunkedProcessor(numOfThreads);
+
+    auto cpattern  = wcmatch.compile(benchPattern);
+
+    size_t found = 0;
+    for (auto _ : state) {
+        found = processor.execute(freader, benchFileName, *cpattern);
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.counters["Count"] = found;
+}
+
+static void genChunkedArguments(benchmark::internal::Benchmark* b) {
+    b
+    // numOfThreads, the same numbers of threads as in genMultithreadingArguments
+
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+
+    ->ArgNames({"threads" })
+    ->Unit(benchmark::kMillisecond)
+    ->MeasureProcessCPUTime()
+    ->UseRealTime();
+}
+
+BENCHMARK(BM_MMapChunked<MyWildcardMatch>)
+    ->Apply(genChunkedArguments);
+
+BENCHMARK(BM_MMapChunked<SIMDWildcardMatch>)
+    ->Apply(genChunkedArguments);
+
+// Only splitting of the file into lines: memchr per line (index:0)
+// or NewlineIndex with up to 'mlines' newlines per scan
+void BM_LineSplitting(benchmark::State& state) {
+
+    const bool   useIndex = state.range(0);
+    const size_t maxLines = state.range(1);
+
+    auto freader = MMapReader();
+    ScopedFileOpener fopener(freader, benchFileName);
+    const auto data = freader.data();
+
+    NewlineIndex index(maxLines);
+
+    size_t numOfLines = 0;
+    for (auto _ : state) {
+        const char* pos = data.data();
+        const char* end = pos + data.size();
+        numOfLines = 0;
+
+        while(pos < end) {
+            if(useIndex) {
+                const char* scanEnd = end - pos > UINT32_MAX ? pos + UINT32_MAX : end;
+                const size_t count = index.build(pos, scanEnd, maxLines);
+                const char* lineBegin = pos;
+                for(size_t i = 0; i < count; ++i) {
+                    FileLineRef line { lineBegin, static_cast<size_t>(pos + index[i] - lineBegin) };
+                    benchmark::DoNotOptimize(line);
+                    lineBegin = pos + index[i] + 1;
+                }
+                numOfLines += count;
+                // the last line without newline
+                pos = count ? lineBegin : scanEnd;
+                numOfLines += !count;
+            }
+            else {
+                const char* eol = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+                FileLineRef line { pos, static_cast<size_t>((eol ? eol : end) - pos) };
+                benchmark::DoNotOptimize(line);
+                pos = eol ? eol + 1 : end;
+                ++numOfLines;
+            }
+        }
+    }
+
+    state.counters["Lines"] = numOfLines;
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+BENCHMARK(BM_LineSplitting)
+    // useIndex, maxLines
+    ->Args({0, 1})
+    ->Args({1, 16})
+    ->Args({1, 256})
+    ->Args({1, 4096})
+
+    ->ArgNames({"index", "mlines" })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// LinesBlock (FileLineRef + offset per line) vs CompactLinesBlock
+// (4 bytes per line) passed between threads
+template<typename Processor>
+void BM_BlockLayout(benchmark::State& state) {
+    MTProdConsTempl<Processor, MMapReader, MyWildcardMatch>(state);
+}
+
+static void genBlockLayoutArguments(benchmark::internal::Benchmark* b) {
+    b
+    // queueSize, numOfThreads, byte budget of a block in KB
+    ->Args({8,  4, 16})
+    ->Args({8,  4, 64})
+    ->Args({8,  4, 256})
+    ->Args({32, 4, 16})
+    ->Args({32, 4, 64})
+    ->Args({32, 4, 256})
+
+    ->ArgNames({"qsize", "threads", "kbytes" })
+    ->Unit(benchmark::kMillisecond)
+    ->MeasureProcessCPUTime()
+    ->UseRealTime();
+}
+
+BENCHMARK(BM_BlockLayout<MTLockFreeProcessor>)
+    ->Apply(genBlockLayoutArguments);
+
+BENCHMARK(BM_BlockLayout<MTLockFreeCompactProcessor>)
+    ->Apply(genBlockLayoutArguments);
+
+BENCHMARK(BM_BlockLayout<MTCondVarProcessor2>)
+    ->Apply(genBlockLayoutArguments);
+
+BENCHMARK(BM_BlockLayout<MTCondVarCompactProcessor2>)
+    ->Apply(genBlockLayoutArguments);
+
+// Found lines are written into /dev/null to see the cost of the output
+// itself without a terminal or disk
+class NullOutput final: private noncopyable
+{
+public:
+    NullOutput(): _fd(::open("/dev/null", O_WRONLY)) {
+        if(_fd < 0) {
+            errorAndStop("Opening of /dev/null failed");
+        }
+    }
+
+    ~NullOutput() { ::close(_fd); }
+
+    int fd() const noexcept { return _fd; }
+
+private:
+    int _fd;
+};
+
+template<typename FReader>
+void BM_SequentialOutput(benchmark::State& state) {
+
+    const size_t maxLines  = state.range(0);
+    const bool   withPrefix = state.range(1) != 0;
+
+    NullOutput output;
+    FdLineSink sink(output.fd(), withPrefix, withPrefix);
+
+    auto freader   = FReader();
+    auto wcmatch   = MyWildcardMatch();
+    auto processor = SequentialProcessor(maxLines, freader.needsBuffer());
+
+    auto cpattern  = wcmatch.compile(benchPattern);
+
+    size_t found = 0;
+    for (auto _ : state) {
+        found = processor.execute(freader, benchFileName, *cpattern, &sink);
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.counters["Count"] = found;
+}
+
+static void genSequentialOutputArguments(benchmark::internal::Benchmark* b) {
+    b
+    // maxLines, line numbers and offsets
+    ->Args({32, 0})
+    ->Args({32, 1})
+    ->ArgNames({"mlines", "prefix" })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+}
+
+BENCHMARK(BM_SequentialOutput<FGetsReader>)
+    ->Apply(genSequentialOutputArguments);
+
+BENCHMARK(BM_SequentialOutput<MMapReader>)
+    ->Apply(genSequentialOutputArguments);
+
+template<typename Processor>
+void BM_MTOutput(benchmark::State& state) {
+
+    const size_t queueSize     = state.range(0);
+    const size_t numOfThreads  = state.range(1);
+    const size_t maxLines      = state.range(2);
+    const size_t reorderWindow = state.range(3);
+
+    NullOutput output;
+    FdLineSink sink(output.fd(), true, true);
+
+    auto freader   = MMapReader();
+    auto wcmatch   = MyWildcardMatch();
+    auto processor = Processor(queueSize, numOfThreads - 1,
+                                    maxLines, freader.needsBuffer());
+    processor.setOrderedOutput(reorderWindow);
+
+    auto cpattern  = wcmatch.compile(benchPattern);
+
+    size_t found = 0;
+    for (auto _ : state) {
+        found = processor.execute(freader, benchFileName, *cpattern, &sink);
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.counters["Count"] = found;
+}
+
+static void genMTOutputArguments(benchmark::internal::Benchmark* b) {
+    b
+    // queueSize, numOfThreads, maxLines, reorderWindow (0 - unordered output)
+    ->Args({8,   4, 256, 0})
+    ->Args({8,   4, 256, 8})
+    ->Args({8,   4, 256, 32})
+    ->Args({16,  8, 256, 0})
+    ->Args({16,  8, 256, 16})
+    ->Args({16,  8, 256, 64})
+    ->ArgNames({"qsize", "threads", "mlines", "reorder" })
+    ->Unit(benchmark::kMillisecond)
+    ->MeasureProcessCPUTime()
+    ->UseRealTime();
+}
+
+BENCHMARK(BM_MTOutput<MTCondVarProcessor>)
+    ->Apply(genMTOutputArguments);
+
+BENCHMARK(BM_MTOutput<MTLockFreeProcessor>)
+    ->Apply(genMTOutputArguments);
+
+BENCHMARK(BM_MTOutput<MTSemProcessor>)
+    ->Apply(genMTOutputArguments);
+
+BENCHMARK(BM_MTOutput<MPMCProcessor>)
+    ->Apply(genMTOutputArguments);
+
+// Full mapped file against windowed mapping with different windows,
+// peak resident memory is shown in MB
+template<typename FReader>
+void PeakRSSTempl(benchmark::State& state, FReader& freader) {
+
+    auto wcmatch   = SIMDWildcardMatch();
+    auto processor = SequentialProcessor(32, freader.needsBuffer());
+
+    auto cpattern  = wcmatch.compile(benchPattern);
+
+    resetPeakRSS();
+
+    size_t found = 0;
+    for (auto _ : state) {
+        found = processor.execute(freader, benchFileName, *cpattern);
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.counters["Count"] = found;
+    state.counters["PeakRSS"] = peakRSS();
+}
+
+static void BM_PeakRSSFullMap(benchmark::State& state) {
+    auto freader = MMapReader();
+    PeakRSSTempl(state, freader);
+}
+
+static void BM_PeakRSSWindowed(benchmark::State& state) {
+    const size_t windowSize = state.range(0) * 1024 * 1024;
+    const bool   dropCache  = state.range(1) != 0;
+
+    auto freader = WMMapReader(windowSize, dropCache);
+    PeakRSSTempl(state, freader);
+}
+
+BENCHMARK(BM_PeakRSSFullMap)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_PeakRSSWindowed)
+    // window size in MB, drop pages from page cache
+    ->Args({32,  0})
+    ->Args({256, 0})
+    ->Args({256, 1})
+    ->ArgNames({"window", "dropcache" })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Files from a directory tree, each file is processed separately
+// with one sequential processor, it is the base line for BM_Batch.
+template<typename FReader>
+void BM_BatchSequential(benchmark::State& state) {
+
+    if(benchBatchDir.empty()) {
+        state.SkipWithError("Environment variable BENCH_BATCH_DIR is not set");
+        return;
+    }
+
+    const size_t maxLines = state.range(0);
+
+    auto freader   = FReader();
+    auto wcmatch   = MyWildcardMatch();
+    auto processor = SequentialProcessor(maxLines, freader.needsBuffer());
+
+    auto cpattern  = wcmatch.compile(benchPattern);
+    auto filenames = BatchProcessor::listFiles(benchBatchDir, benchBatchGlob);
+
+    size_t found = 0;
+    for (auto _ : state) {
+        found = 0;
+        for(auto const& filename: filenames) {
+            found += processor.execute(freader, filename, *cpattern);
+        }
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.counters["Count"] = found;
+    state.counters["Files"] = filenames.size();
+}
+
+BENCHMARK(BM_BatchSequential<FGetsReader>)
+    ->Arg(32)
+    ->ArgNames({"mlines", })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_BatchSequential<MMapReader>)
+    ->Arg(32)
+    ->ArgNames({"mlines", })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+template<typename FReader>
+void BM_Batch(benchmark::State& state) {
+
+    if(benchBatchDir.empty()) {
+        state.SkipWithError("Environment variable BENCH_BATCH_DIR is not set");
+        return;
+    }
+
+    const size_t numOfThreads = state.range(0);
+    const size_t maxLines     = state.range(1);
+    const size_t chunkSize    = state.range(2) * 1024 * 1024;
+
+    auto wcmatch   = MyWildcardMatch();
+    auto processor = BatchProcessor(numOfThreads, maxLines,
+                        []() { return std::make_unique<FReader>(); }, chunkSize);
+
+    auto cpattern  = wcmatch.compile(benchPattern);
+    auto filenames = BatchProcessor::listFiles(benchBatchDir, benchBatchGlob);
+
+    size_t found = 0;
+    for (auto _ : state) {
+        found = processor.execute(filenames, *cpattern);
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.counters["Count"] = found;
+    state.counters["Files"] = filenames.size();
+}
+
+static void genBatchArguments(benchmark::internal::Benchmark* b) {
+    b
+    // numOfThreads, maxLines, chunkSize in MB
+
+    ->Args({1, 32, 32})
+    ->Args({2, 32, 32})
+    ->Args({4, 32, 8})
+    ->Args({4, 32, 32})
+    ->Args({8, 32, 32})
+
+    ->ArgNames({"threads", "mlines", "chunk" })
+    ->Unit(benchmark::kMillisecond)
+    ->MeasureProcessCPUTime()
+    ->UseRealTime();
+}
+
+BENCHMARK(BM_Batch<FGetsReader>)
+    ->Apply(genBatchArguments);
+
+BENCHMARK(BM_Batch<FStreamReader>)
+    ->Apply(genBatchArguments);
+
+BENCHMARK(BM_Batch<MMapReader>)
+    ->Apply(genBatchArguments);
+
+BENCHMARK(BM_Batch<UringReader>)
+    ->Apply(genBatchArguments);
+
+BENCHMARK(BM_Batch<BlockReader>)
+    ->Apply(genBatchArguments);
+
+// Compress the file with gzip
+static bool makeGzipFile(const std::string& srcFileName, const std::string& fileName) {
+
+    std::ifstream src(srcFileName, std::ios::binary);
+    if(!src) {
+        return false;
+    }
+
+    gzFile file = gzopen(fileName.c_str(), "wb6");
+    if(!file) {
+        return false;
+    }
+
+    std::vector<char> buffer(1024 * 1024);
+    bool written = true;
+    while(written && src) {
+        src.read(buffer.data(), buffer.size());
+        const auto size = src.gcount();
+        if(size > 0) {
+            written = gzwrite(file, buffer.data(), size) == size;
+        }
+    }
+
+    return gzclose(file) == Z_OK && written;
+}
+
+// Generate file with skewed load for consumers: regions of short lines,
+// regions of long lines and regions where almost all lines are matched
+// by patterns like '*failed*' with a lot of backtracking.
+static bool makeSkewedFile(const std::string& fileName) {
+
+    constexpr size_t fileSize   = 256 * 1024 * 1024;
+    constexpr size_t regionSize = 4 * 1024 * 1024;
+
+    std::ofstream file(fileName, std::ios::binary);
+    if(!file) {
+        return false;
+    }
+
+    std::mt19937 rng(12345);
+    const std::string words[] = {
+        "sync", "update", "file", "copied", "deleted", "ok", "path/to/some/file",
+    };
+    auto randomWord = [&]() -> const std::string& {
+        return words[rng() % std::size(words)];
+    };
+
+    std::string line;
+    size_t written = 0;
+    for(size_t region = 0; written < fileSize; ++region) {
+        const size_t regionEnd = written + regionSize;
+        while(written < regionEnd) {
+            line.clear();
+            switch(region % 3) {
+            case 0: // short lines
+                for(size_t i = rng() % 4 + 1; i > 0; --i) {
+                    line += randomWord() + ' ';
+                }
+                break;
+            case 1: // long lines
+                while(line.size() < 1500) {
+                    line += randomWord() + ' ';
+                }
+                break;
+            default: // matched lines with many partial matches
+                for(size_t i = rng() % 60 + 20; i > 0; --i) {
+                    line += "fail f fa fai faile ";
+                }
+                line += "failed";
+                break;
+            }
+            line += '\n';
+            file << line;
+            written += line.size();
+        }
+    }
+
+    return static_cast<bool>(file);
+}
+
+static bool handleEnvVars() {
+
+    const char* envvar = nullptr;
+
+    auto printErr = [](const std::string& msg) {
         std::cerr << msg << std::endl;
     };
 
@@ -291,6 +1548,45 @@ static bool handleEnvVars() {
     }
     benchPattern = envvar;
 
+    // optional small file for benchmarks of many short jobs
+    envvar = std::getenv("BENCH_SMALL_FILENAME");
+    if(envvar) {
+        benchSmallFileName = envvar;
+    }
+
+    // optional skewed file, it is generated if it does not exist
+    envvar = std::getenv("BENCH_SKEWED_FILENAME");
+    if(envvar) {
+        benchSkewedFileName = envvar;
+        if(!std::filesystem::exists(benchSkewedFileName) &&
+                                    !makeSkewedFile(benchSkewedFileName)) {
+            printErr("Cannot generate file " + benchSkewedFileName);
+            return false;
+        }
+    }
+
+    // optional directory tree for batch benchmarks and glob for its files
+    envvar = std::getenv("BENCH_BATCH_DIR");
+    if(envvar) {
+        benchBatchDir = envvar;
+    }
+
+    envvar = std::getenv("BENCH_BATCH_GLOB");
+    if(envvar) {
+        benchBatchGlob = envvar;
+    }
+
+    // optional compressed file, it is generated if it does not exist
+    envvar = std::getenv("BENCH_COMPRESSED_FILENAME");
+    if(envvar) {
+        benchCompressedFileName = envvar;
+        if(!std::filesystem::exists(benchCompressedFileName) &&
+                            !makeGzipFile(benchFileName, benchCompressedFileName)) {
+            printErr("Cannot generate file " + benchCompressedFileName);
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -0,0 +1,348 @@
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "utils.h"
+#include "blockreader.h"
+
+namespace fwc {
+
+// chunks are read from offsets aligned to it,
+// it is enough for O_DIRECT on usual file systems
+static constexpr size_t CHUNK_ALIGNMENT = 4096;
+
+static size_t alignDown(size_t value, size_t alignment) {
+    return value - value % alignment;
+}
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return alignDown(value + alignment - 1, alignment);
+}
+
+BlockReader::BlockReader(size_t chunkSize, bool zeroCopy, CachePolicy cachePolicy):
+    _chunkSize(std::max(alignDown(chunkSize, CHUNK_ALIGNMENT), CHUNK_ALIGNMENT)),
+    _zeroCopy(zeroCopy),
+    _cachePolicy(cachePolicy) {
+
+    _chunks.resize(2, _chunkSize);
+
+    if(_zeroCopy) {
+        // the end of one chunk and the beginning of the next one
+        _spanBuffer.resize(2 * _chunkSize);
+    }
+}
+
+BlockReader::~BlockReader() {
+    close();
+}
+
+// open file
+void BlockReader::open(const std::string& filename) {
+    if(filename.empty()) {
+        errorAndStop("File name is empty", false);
+    }
+
+    if(_file >= 0) {
+        // file is open
+        return;
+    }
+
+    _directIO = false;
+    if(CachePolicy::Direct == _cachePolicy) {
+        _file = ::open(filename.c_str(), O_RDONLY | O_DIRECT);
+        _directIO = _file >= 0;
+    }
+    if(-1 == _file) {
+        // O_DIRECT can be not supported by the file system
+        _file = ::open(filename.c_str(), O_RDONLY);
+    }
+    if(-1 == _file) {
+        errorAndStop("File opening failed");
+    }
+
+    struct stat sb;
+    if (::fstat(_file, &sb) == -1) {
+        errorAndStop("fstat");
+    }
+    _fileSize = sb.st_size;
+
+    if(!_directIO) {
+        ::posix_fadvise(_file, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    // the first chunk is read into the first buffer
+    _readOffset = 0;
+    _current = 1;
+    _locked = NO_CHUNK;
+    _spanUsed = false;
+    _pos = _end = nullptr;
+    resetPosition();
+}
+
+// close file
+void BlockReader::close() {
+    if(_file >= 0) {
+        ::close(_file);
+        _file = -1;
+    }
+
+    _pos = _end = nullptr;
+}
+
+bool BlockReader::loadNext() {
+
+    if(_readOffset >= _fileSize) {
+        return false;
+    }
+
+    const size_t next = 1 - _current;
+    char* data = _chunks.get(next);
+    const size_t size = std::min(_chunkSize, _fileSize - _readOffset);
+
+    size_t done = 0;
+    while(done < size) {
+        // with O_DIRECT the size is aligned too, the file just ends earlier
+        const size_t request = (_directIO ? alignUp(size, CHUNK_ALIGNMENT) : size) - done;
+        auto res = ::pread(_file, data + done, request, _readOffset + done);
+        if(res < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            if(errno == EINVAL && _directIO) {
+                // O_DIRECT is not supported for this file or a read was short,
+                // chunks are dropped from the page cache instead
+                ::fcntl(_file, F_SETFL, ::fcntl(_file, F_GETFL) & ~O_DIRECT);
+                _directIO = false;
+                continue;
+            }
+            errorAndStop("pread");
+        }
+        if(!res) {
+            // file is truncated
+            _fileSize = _readOffset + done;
+            break;
+        }
+        done += res;
+    }
+
+    if(!done) {
+        return false;
+    }
+
+    // the file could grow
+    done = std::min(done, size);
+
+    if(CachePolicy::Keep != _cachePolicy && !_directIO) {
+        ::posix_fadvise(_file, _readOffset, done, POSIX_FADV_DONTNEED);
+    }
+
+    _readOffset += done;
+    _current = next;
+    _pos = data;
+    _end = data + done;
+
+    if(_readOffset < _fileSize && !_directIO) {
+        // let the kernel read the next chunk while this one is processed
+        ::posix_fadvise(_file, _readOffset, _chunkSize, POSIX_FADV_WILLNEED);
+    }
+
+    return true;
+}
+
+bool BlockReader::loadAt(size_t offset) {
+
+    const size_t chunkOffset = alignDown(offset, CHUNK_ALIGNMENT);
+    _readOffset = chunkOffset;
+    _current = 1;
+    _locked = NO_CHUNK;
+    _spanUsed = false;
+    _pos = _end = nullptr;
+
+    if(!loadNext()) {
+        return false;
+    }
+
+    _pos += offset - chunkOffset;
+    return _pos < _end;
+}
+
+void BlockReader::startBlock() {
+
+    if(!_zeroCopy) {
+        return;
+    }
+
+    if(_pos == _end) {
+        loadNext();
+    }
+
+    // the chunk which has the first line of the block must not be overwritten
+    // while the block is being read
+    _locked = _current;
+    _spanUsed = false;
+}
+
+// read next line in file
+FileLineRef BlockReader::readLine() {
+
+    // It is experimental code and so I don't do correct error handling for all cases
+    assert(_file >= 0);
+
+    return _zeroCopy ? readLineZeroCopy() : readLineCopy();
+}
+
+FileLineRef BlockReader::readLineZeroCopy() {
+
+    // the next chunk can't be read into the locked buffer till the next block
+    auto blockEnded = [this]() {
+        return _readOffset < _fileSize && 1 - _current == _locked;
+    };
+
+    if(_pos == _end) {
+        if(blockEnded() || !loadNext()) {
+            return {};
+        }
+    }
+
+    const char* eol = static_cast<const char*>(std::memchr(_pos, '\n', _end - _pos));
+    if(eol) {
+        FileLineRef line { _pos, static_cast<size_t>(eol - _pos) };
+        advancePosition(line.size() + 1);
+        _pos = eol + 1;
+
+        // strip newline symbol
+        if(!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        return line;
+    }
+
+    if(_readOffset >= _fileSize) {
+        // the last line without newline, the chunk is not overwritten anymore
+        FileLineRef line { _pos, static_cast<size_t>(_end - _pos) };
+        advancePosition(line.size());
+        _pos = _end;
+        return line;
+    }
+
+    // the line crosses chunks so it is copied, the span buffer
+    // keeps only one line so the block is ended before the second one
+    if(blockEnded() || _spanUsed) {
+        return {};
+    }
+
+    _spanUsed = true;
+    char* span = _spanBuffer.data();
+    size_t lineSize = _end - _pos;
+    std::memcpy(span, _pos, lineSize);
+    size_t consumed = lineSize;
+    _pos = _end;
+
+    if(loadNext()) {
+        eol = static_cast<const char*>(std::memchr(_pos, '\n', _end - _pos));
+        const size_t tailSize = (eol ? eol : _end) - _pos;
+        std::memcpy(span + lineSize, _pos, tailSize);
+        lineSize += tailSize;
+        consumed += tailSize;
+        _pos += tailSize;
+
+        if(eol) {
+            // strip newline symbol,
+            // a line longer than a chunk is split otherwise
+            ++_pos;
+            ++consumed;
+            if(lineSize && span[lineSize - 1] == '\r') {
+                --lineSize;
+            }
+        }
+    }
+
+    advancePosition(consumed);
+    return { span, lineSize };
+}
+
+FileLineRef BlockReader::readLineCopy() {
+
+    assert(_buffer && _bufferSize > 1);
+
+    size_t consumed = 0;
+    bool newline = false;
+    startLine();
+
+    for(;;) {
+        if(_pos == _end && !loadNext()) {
+            // end of file, may be with the last line without newline
+            if(!consumed) {
+                return {};
+            }
+            break;
+        }
+
+        const char* eol = static_cast<const char*>(std::memchr(_pos, '\n', _end - _pos));
+        const size_t partSize = (eol ? eol : _end) - _pos;
+        const size_t copySize = appendToLine(_pos, partSize);
+        consumed += copySize;
+        _pos += copySize;
+
+        if(copySize < partSize) {
+            // line is longer than the buffer and there is no overflow arena,
+            // the rest is the next line
+            break;
+        }
+
+        if(eol) {
+            // skip newline symbol, it is stripped by takeLine
+            ++_pos;
+            ++consumed;
+            newline = true;
+            break;
+        }
+
+        // the line continues in the next chunk
+    }
+
+    advancePosition(consumed);
+    return takeLine(newline);
+}
+
+bool BlockReader::seek(size_t offset) {
+
+    assert(_file >= 0);
+
+    // begin from the previous symbol to see whether it is a newline
+    const size_t from = offset ? std::min(offset, _fileSize) - 1 : 0;
+    if(!loadAt(from)) {
+        resetPosition(_fileSize);
+        return true;
+    }
+
+    size_t pos = from;
+    if(offset) {
+        // skip the rest of the line (or only newline before the offset)
+        for(;;) {
+            if(_pos == _end && !loadNext()) {
+                break;
+            }
+
+            const char* eol = static_cast<const char*>(std::memchr(_pos, '\n', _end - _pos));
+            if(eol) {
+                pos += eol + 1 - _pos;
+                _pos = eol + 1;
+                break;
+            }
+
+            pos += _end - _pos;
+            _pos = _end;
+        }
+    }
+
+    resetPosition(pos);
+    return true;
+}
+
+} // namespace fwc
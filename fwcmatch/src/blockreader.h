@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "filereader.h"
+
+namespace fwc {
+
+/*
+Reader which reads a file by big chunks (1-16 MB) with pread into a double
+buffer and splits lines inside a chunk. It can be used where mmap is not
+allowed (e.g. on some network file systems). The next chunk is advised to
+the kernel (POSIX_FADV_WILLNEED) so it is read ahead while the current one
+is processed.
+By default lines are copied into the line buffer as other readers do. In
+zero-copy mode lines refer to the chunk buffers directly and only a line
+which crosses chunks is copied (one such line per block). Such lines are
+valid only until the next block is read, so zero-copy mode is only for
+processing where a block is processed before reading the next one
+(SequentialProcessor, BatchProcessor), multi-threaded processors reject
+it. A block is ended earlier if its first chunk would be overwritten, so
+a block spans two chunks at most. Growing files are not supported (there is
+no 'refresh'), so the reader can't be used with FollowProcessor.
+A file which is scanned once can be kept out of the page cache: with
+CachePolicy::Direct it is read with O_DIRECT (chunk buffers are aligned to
+pages), with CachePolicy::Drop or if the file system doesn't support O_DIRECT
+every chunk is dropped from the page cache (POSIX_FADV_DONTNEED) after it's read.
+*/
+
+class BlockReader final: public FileReader
+{
+public:
+
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 4*1024*1024;
+
+    enum class CachePolicy
+    {
+        Keep,   // use the page cache as usual
+        Direct, // bypass the page cache with O_DIRECT
+        Drop    // drop read chunks from the page cache
+    };
+
+    explicit BlockReader(size_t chunkSize = DEFAULT_CHUNK_SIZE, bool zeroCopy = false,
+                            CachePolicy cachePolicy = CachePolicy::Keep);
+    ~BlockReader();
+
+    // open file
+    void open(const std::string& filename) override;
+
+    // close file
+    void close() override;
+
+    bool needsBuffer() const override { return !_zeroCopy; } ;
+
+    bool keepsLines() const override { return !_zeroCopy; }
+
+    // read next line in file
+    // FileLineRef is used to avoid copying
+    FileLineRef readLine() override;
+
+    bool seek(size_t offset) override;
+    bool canSeek() const override { return true; }
+
+    void startBlock() override;
+
+    // false if the file is read through the page cache
+    [[nodiscard]]
+    bool usesDirectIO() const noexcept { return _directIO; }
+
+private:
+
+    FileLineRef readLineCopy();
+    FileLineRef readLineZeroCopy();
+
+    // read the next chunk into the other buffer, returns false at the end of file
+    bool loadNext();
+
+    // read the chunk which contains the offset into the buffer
+    // and set the current position to the offset
+    bool loadAt(size_t offset);
+
+    static constexpr size_t NO_CHUNK = 2;
+
+    BlocksBuffer      _chunks;
+    std::vector<char> _spanBuffer;
+    size_t            _current    { 0 };
+    size_t            _locked     { NO_CHUNK };
+    bool              _spanUsed   { false }; // a line of the block is in the span buffer
+    const char*       _pos        { nullptr };
+    const char*       _end        { nullptr };
+    size_t            _readOffset { 0 };
+    size_t            _fileSize   { 0 };
+    int               _file       { -1 };
+    bool              _directIO   { false };
+    const size_t      _chunkSize;
+    const bool        _zeroCopy;
+    const CachePolicy _cachePolicy;
+};
+
+} // namespace fwc
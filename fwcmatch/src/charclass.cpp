@@ -0,0 +1,159 @@
+#include <cassert>
+#include <cctype>
+#include <string>
+#include <utility>
+
+#include "charclass.h"
+
+namespace fwc {
+
+void addOtherCase(ByteSet& set) noexcept {
+    for(unsigned char c = 'a'; c <= 'z'; ++c) {
+        const unsigned char upper = c - 'a' + 'A';
+        if(set[c] || set[upper]) {
+            set.set(c);
+            set.set(upper);
+        }
+    }
+}
+
+// POSIX class '[:name:]' in the C locale, returns false for unknown names
+static bool addNamedClass(std::string_view name, ByteSet& set) {
+
+    using Check = int (*)(int);
+    static constexpr std::pair<std::string_view, Check> classes[] = {
+        { "alnum", &isalnum }, { "alpha", &isalpha }, { "blank", &isblank },
+        { "cntrl", &iscntrl }, { "digit", &isdigit }, { "graph", &isgraph },
+        { "lower", &islower }, { "print", &isprint }, { "punct", &ispunct },
+        { "space", &isspace }, { "upper", &isupper }, { "xdigit", &isxdigit }
+    };
+
+    for(auto const& [className, check]: classes) {
+        if(className != name) {
+            continue;
+        }
+        // only ASCII, the result for other bytes depends on the locale
+        for(int c = 0; c < 128; ++c) {
+            if(check(c)) {
+                set.set(c);
+            }
+        }
+        return true;
+    }
+
+    return false;
+}
+
+size_t parseBracket(std::string_view pattern, size_t pos, bool escapes,
+                            bool ignoreCase, ByteSet& set, bool* invalidElement) {
+
+    assert(pos < pattern.size() && '[' == pattern[pos]);
+
+    // the bracket can't match anything, the whole rest of the pattern is taken
+    auto invalid = [&] {
+        if(invalidElement) {
+            *invalidElement = true;
+        }
+        set.reset();
+        return pattern.size();
+    };
+
+    enum class Element { INVALID, BYTE, COLLATING, EQUIVALENCE };
+
+    // Read one byte at 'i': ordinary, escaped or a collating element like
+    // '[.-.]' or '[=a=]'
+    auto readByte = [&](size_t& i, unsigned char& c) {
+        c = pattern[i];
+        if('[' == c && i + 1 < pattern.size() &&
+                    ('.' == pattern[i + 1] || '=' == pattern[i + 1])) {
+            const char kind = pattern[i + 1];
+            const auto end = pattern.find(std::string{ kind, ']' }, i + 2);
+            if(end == i + 3) {
+                c = pattern[i + 2];
+                i = end + 2;
+                return '.' == kind ? Element::COLLATING : Element::EQUIVALENCE;
+            }
+            if('.' == kind) {
+                // elements of many bytes are not supported by the C locale
+                return Element::INVALID;
+            }
+        }
+        if('\\' == c && escapes && i + 1 < pattern.size()) {
+            c = pattern[++i];
+        }
+        ++i;
+        return Element::BYTE;
+    };
+
+    // Like fnmatch with FNM_CASEFOLD bytes and ranges are compared with
+    // the lower case of a text byte, classes and collating elements are
+    // compared with the byte itself (and are not folded as ends of ranges)
+    ByteSet folded;
+    ByteSet exact;
+
+    size_t i = pos + 1;
+    const bool negate = i < pattern.size() && ('!' == pattern[i] || '^' == pattern[i]);
+    if(negate) {
+        ++i;
+    }
+
+    for(bool first = true; i < pattern.size(); first = false) {
+        if(']' == pattern[i] && !first) {
+            for(size_t b = 0; b < set.size(); ++b) {
+                set[b] = (folded[ignoreCase ? CASE_FOLD[b] : b] || exact[b]) != negate;
+            }
+            return i + 1;
+        }
+
+        if('[' == pattern[i] && i + 1 < pattern.size() && ':' == pattern[i + 1]) {
+            auto nameEnd = pattern.find(":]", i + 2);
+            if(nameEnd != std::string_view::npos) {
+                if(!addNamedClass(pattern.substr(i + 2, nameEnd - i - 2), exact)) {
+                    return invalid();
+                }
+                i = nameEnd + 2;
+                continue;
+            }
+        }
+
+        unsigned char c;
+        const auto element = readByte(i, c);
+        if(element == Element::INVALID) {
+            return invalid();
+        }
+        if(element == Element::EQUIVALENCE) {
+            exact.set(c);
+            continue;
+        }
+
+        // 'a-z', '-' is an ordinary byte before ']'
+        if(i + 1 < pattern.size() && '-' == pattern[i] && ']' != pattern[i + 1]) {
+            ++i;
+            unsigned char to;
+            const auto toElement = readByte(i, to);
+            if(toElement == Element::INVALID) {
+                return invalid();
+            }
+            if(ignoreCase) {
+                c  = element == Element::BYTE ? CASE_FOLD[c] : c;
+                to = toElement == Element::BYTE ? CASE_FOLD[to] : to;
+            }
+            // a reversed range is empty
+            for(unsigned b = c; b <= to; ++b) {
+                folded.set(b);
+            }
+            continue;
+        }
+
+        if(element == Element::COLLATING) {
+            exact.set(c);
+        }
+        else {
+            folded.set(ignoreCase ? CASE_FOLD[c] : c);
+        }
+    }
+
+    return std::string_view::npos;
+}
+
+} // namespace fwc
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <array>
+#include <bitset>
+#include <string_view>
+
+namespace fwc {
+
+// Set of bytes which one position of a pattern matches ('?', '[...]')
+using ByteSet = std::bitset<256>;
+
+// ASCII letters in lower case, other bytes are the same. Texts are compared
+// case insensitively through it without copying.
+inline constexpr std::array<unsigned char, 256> CASE_FOLD = [] {
+    std::array<unsigned char, 256> table {};
+    for(size_t c = 0; c < table.size(); ++c) {
+        table[c] = (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+    }
+    return table;
+}();
+
+[[nodiscard]]
+constexpr bool isAsciiLetter(unsigned char c) noexcept {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+// add the other case for each ASCII letter in the set
+void addOtherCase(ByteSet& set) noexcept;
+
+// Parse a bracket expression which starts with '[' at 'pos' like fnmatch:
+// [abc], [a-z], [!a-z] or [^a-z], [[:alpha:]] and other POSIX classes of
+// the C locale, collating elements of one byte [[.-.]] and [[=a=]].
+// ']' is an ordinary byte just after '[' or '[!'. If 'escapes' is true '\'
+// makes the next byte ordinary. If 'ignoreCase' is true bytes and ranges
+// are matched in any case (like fnmatch with FNM_CASEFOLD), classes and
+// collating elements are not.
+// Returns the position after the closing ']' or 'npos' if there is no one,
+// then '[' is supposed to be an ordinary byte. An unknown class or
+// a collating element of many bytes can't be matched, then the set is
+// empty, the whole rest of the pattern is taken and 'invalidElement' (if
+// it's not null) is set to true.
+[[nodiscard]]
+size_t parseBracket(std::string_view pattern, size_t pos, bool escapes,
+                    bool ignoreCase, ByteSet& set, bool* invalidElement = nullptr);
+
+} // namespace fwc
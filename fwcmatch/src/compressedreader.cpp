@@ -0,0 +1,495 @@
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <zlib.h>
+
+#ifdef FWC_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#include "utils.h"
+#include "compressedreader.h"
+
+namespace fwc {
+
+namespace {
+
+// Decoder of one frame
+class Decoder
+{
+public:
+    virtual ~Decoder() = default;
+
+    // start decoding of the frame
+    virtual void reset(std::string_view frame) = 0;
+
+    // decode into the buffer, returns number of written bytes,
+    // 'end' is set when the whole frame is decoded
+    virtual size_t decode(char* out, size_t size, bool& end) = 0;
+};
+
+// Plain data
+class CopyDecoder final: public Decoder
+{
+public:
+
+    void reset(std::string_view frame) override {
+        _input = frame;
+    }
+
+    size_t decode(char* out, size_t size, bool& end) override {
+        const size_t n = std::min(size, _input.size());
+        std::memcpy(out, _input.data(), n);
+        _input.remove_prefix(n);
+        end = _input.empty();
+        return n;
+    }
+
+private:
+    std::string_view _input;
+};
+
+// Gzip (and zlib) data, several concatenated gzip members are decoded as one
+class GzipDecoder final: public Decoder
+{
+public:
+
+    GzipDecoder() {
+        // 32 means automatic detection of gzip/zlib header
+        if(inflateInit2(&_zs, 15 + 32) != Z_OK) {
+            errorAndStop("inflateInit2 failed", false);
+        }
+    }
+
+    ~GzipDecoder() {
+        inflateEnd(&_zs);
+    }
+
+    void reset(std::string_view frame) override {
+        inflateReset(&_zs);
+        _input = frame;
+        _zs.next_in = nullptr;
+        _zs.avail_in = 0;
+    }
+
+    size_t decode(char* out, size_t size, bool& end) override {
+
+        if(!_zs.avail_in && !_input.empty()) {
+            // avail_in is 32 bits only
+            const size_t n = std::min<size_t>(_input.size(), MAX_AVAIL_IN);
+            _zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(_input.data()));
+            _zs.avail_in = n;
+            _input.remove_prefix(n);
+        }
+
+        _zs.next_out = reinterpret_cast<Bytef*>(out);
+        _zs.avail_out = size;
+
+        const int res = inflate(&_zs, Z_NO_FLUSH);
+        const bool inputLeft = _zs.avail_in || !_input.empty();
+
+        if(res == Z_STREAM_END) {
+            if(inputLeft && peekInput(0) == 0x1f && peekInput(1) == 0x8b) {
+                // the next gzip member
+                inflateReset(&_zs);
+            }
+            else {
+                // like gzip, padding or garbage after the last member is ignored
+                end = true;
+            }
+        }
+        else if(res == Z_BUF_ERROR && !inputLeft) {
+            errorAndStop("Compressed data is truncated", false);
+        }
+        else if(res != Z_OK && res != Z_BUF_ERROR) {
+            errorAndStop(std::string("Compressed data is corrupted: ") +
+                            (_zs.msg ? _zs.msg : "unknown error"), false);
+        }
+
+        return size - _zs.avail_out;
+    }
+
+private:
+    static constexpr size_t MAX_AVAIL_IN = 1024*1024*1024;
+
+    // byte 'idx' of input which is not decoded yet, -1 after the end
+    int peekInput(size_t idx) const noexcept {
+        if(idx < _zs.avail_in) {
+            return _zs.next_in[idx];
+        }
+        idx -= _zs.avail_in;
+        return idx < _input.size() ? static_cast<unsigned char>(_input[idx]) : -1;
+    }
+
+    z_stream         _zs {};
+    std::string_view _input;
+};
+
+#ifdef FWC_WITH_ZSTD
+
+// Zstd data, a frame can have several zstd frames too
+class ZstdDecoder final: public Decoder
+{
+public:
+
+    ZstdDecoder(): _ctx(ZSTD_createDCtx()) {
+        if(!_ctx) {
+            errorAndStop("ZSTD_createDCtx failed", false);
+        }
+    }
+
+    ~ZstdDecoder() {
+        ZSTD_freeDCtx(_ctx);
+    }
+
+    void reset(std::string_view frame) override {
+        ZSTD_DCtx_reset(_ctx, ZSTD_reset_session_only);
+        _input = { frame.data(), frame.size(), 0 };
+    }
+
+    size_t decode(char* out, size_t size, bool& end) override {
+
+        ZSTD_outBuffer output { out, size, 0 };
+        const size_t res = ZSTD_decompressStream(_ctx, &output, &_input);
+        if(ZSTD_isError(res)) {
+            errorAndStop(std::string("Compressed data is corrupted: ") +
+                            ZSTD_getErrorName(res), false);
+        }
+
+        const bool inputLeft = _input.pos < _input.size;
+        if(!res && !inputLeft) {
+            end = true;
+        }
+        else if(!output.pos && !inputLeft) {
+            errorAndStop("Compressed data is truncated", false);
+        }
+
+        return output.pos;
+    }
+
+private:
+    ZSTD_DCtx*    _ctx;
+    ZSTD_inBuffer _input {};
+};
+
+#endif
+
+std::unique_ptr<Decoder> makeDecoder(CompressedReader::Compression compression) {
+
+    switch(compression) {
+    case CompressedReader::Compression::Gzip:
+        return std::make_unique<GzipDecoder>();
+#ifdef FWC_WITH_ZSTD
+    case CompressedReader::Compression::Zstd:
+        return std::make_unique<ZstdDecoder>();
+#endif
+    default:
+        return std::make_unique<CopyDecoder>();
+    }
+}
+
+} // namespace
+
+CompressedReader::CompressedReader(size_t bufferSize, size_t queueDepth, size_t numOfThreads):
+    _ringBufferSize(std::max<size_t>(bufferSize, 1)) {
+
+    _streams.resize(std::max<size_t>(numOfThreads, 1));
+    for(auto& stream: _streams) {
+        stream = std::make_unique<Stream>();
+        // memory for buffers is allocated in the first open()
+        stream->buffers.resize(std::max<size_t>(queueDepth, 1));
+    }
+}
+
+CompressedReader::~CompressedReader() {
+    close();
+}
+
+CompressedReader::Compression CompressedReader::detect(std::string_view data) noexcept {
+
+    auto magic = [&data](std::string_view bytes) {
+        return data.substr(0, bytes.size()) == bytes;
+    };
+
+    if(magic("\x1f\x8b")) {
+        return Compression::Gzip;
+    }
+
+    // zstd frame or skippable frame (0x184D2A5?)
+    if(magic("\x28\xb5\x2f\xfd") ||
+        (data.size() >= 4 && (data[0] & 0xF0) == 0x50 && data.substr(1, 3) == "\x2a\x4d\x18")) {
+        return Compression::Zstd;
+    }
+
+    return Compression::None;
+}
+
+// open file
+void CompressedReader::open(const std::string& filename) {
+    if(filename.empty()) {
+        errorAndStop("File name is empty", false);
+    }
+
+    if(_file >= 0) {
+        // file is open
+        return;
+    }
+
+    _file = ::open(filename.c_str(), O_RDONLY);
+    if(-1 == _file) {
+        errorAndStop("File opening failed");
+    }
+
+    struct stat sb;
+    if (::fstat(_file, &sb) == -1) {
+        errorAndStop("fstat");
+    }
+    _fileSize = sb.st_size;
+
+    // compressed data is read by decompressing threads as they go
+    if(_fileSize) {
+        _fileAddr = ::mmap(NULL, _fileSize, PROT_READ, MAP_PRIVATE, _file, 0);
+        if(MAP_FAILED == _fileAddr) {
+            _fileAddr = nullptr;
+            errorAndStop("mmap");
+        }
+        ::madvise(_fileAddr, _fileSize, MADV_SEQUENTIAL);
+    }
+
+    resetPosition();
+
+    _compression = detect({ static_cast<const char*>(_fileAddr), _fileSize });
+#ifndef FWC_WITH_ZSTD
+    if(Compression::Zstd == _compression) {
+        errorAndStop("Zstd compressed files are not supported, build with FWC_WITH_ZSTD", false);
+    }
+#endif
+
+    splitFrames();
+
+    // gzip stream can't be decompressed in parallel
+    const size_t maxStreams = Compression::Zstd == _compression ? _streams.size() : 1;
+    _numOfStreams = std::min(maxStreams, _frames.size());
+
+    _stream = 0;
+    _hasCurrent = false;
+    _pos = _end = nullptr;
+
+    for(size_t i = 0; i < _numOfStreams; ++i) {
+        auto& stream = *_streams[i];
+        stream.head = stream.filled = 0;
+        stream.finished = stream.stopping = false;
+        for(auto& buffer: stream.buffers) {
+            buffer.data.resize(_ringBufferSize);
+        }
+        stream.thread = std::thread(&CompressedReader::decompress, this, std::ref(stream), i);
+    }
+}
+
+// close file
+void CompressedReader::close() {
+
+    stopThreads();
+    _frames.clear();
+    _numOfStreams = 0;
+    _hasCurrent = false;
+    _pos = _end = nullptr;
+
+    if(_fileAddr) {
+        ::munmap(_fileAddr, _fileSize);
+        _fileAddr = nullptr;
+    }
+
+    if(_file >= 0) {
+        ::close(_file);
+        _file = -1;
+    }
+}
+
+void CompressedReader::stopThreads() {
+
+    for(size_t i = 0; i < _numOfStreams; ++i) {
+        auto& stream = *_streams[i];
+        {
+            std::lock_guard lock(stream.mutex);
+            stream.stopping = true;
+        }
+        stream.cond.notify_all();
+    }
+
+    for(size_t i = 0; i < _numOfStreams; ++i) {
+        auto& thread = _streams[i]->thread;
+        if(thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void CompressedReader::splitFrames() {
+
+    _frames.clear();
+    if(!_fileSize) {
+        return;
+    }
+
+    std::string_view data(static_cast<const char*>(_fileAddr), _fileSize);
+
+#ifdef FWC_WITH_ZSTD
+    if(Compression::Zstd == _compression) {
+        while(!data.empty()) {
+            const size_t size = ZSTD_findFrameCompressedSize(data.data(), data.size());
+            if(ZSTD_isError(size)) {
+                // the decoder will report the error
+                break;
+            }
+            _frames.push_back(data.substr(0, size));
+            data.remove_prefix(size);
+        }
+    }
+#endif
+
+    if(!data.empty()) {
+        _frames.push_back(data);
+    }
+}
+
+void CompressedReader::decompress(Stream& stream, size_t firstFrame) {
+
+    auto decoder = makeDecoder(_compression);
+    const size_t numOfBuffers = stream.buffers.size();
+
+    for(size_t f = firstFrame; f < _frames.size(); f += _numOfStreams) {
+
+        decoder->reset(_frames[f]);
+
+        bool frameEnd = false;
+        while(!frameEnd) {
+            Buffer* buffer = nullptr;
+            {
+                std::unique_lock lock(stream.mutex);
+                stream.cond.wait(lock, [&stream, numOfBuffers]() {
+                    return stream.filled < numOfBuffers || stream.stopping;
+                });
+                if(stream.stopping) {
+                    return;
+                }
+                buffer = &stream.buffers[(stream.head + stream.filled) % numOfBuffers];
+            }
+
+            size_t size = 0;
+            while(size < _ringBufferSize && !frameEnd) {
+                size += decoder->decode(buffer->data.data() + size,
+                                            _ringBufferSize - size, frameEnd);
+            }
+            buffer->size = size;
+            buffer->frameEnd = frameEnd;
+
+            {
+                std::lock_guard lock(stream.mutex);
+                ++stream.filled;
+            }
+            stream.cond.notify_all();
+        }
+    }
+
+    {
+        std::lock_guard lock(stream.mutex);
+        stream.finished = true;
+    }
+    stream.cond.notify_all();
+}
+
+bool CompressedReader::nextBuffer() {
+
+    if(_hasCurrent) {
+        // give the current buffer back
+        auto& stream = *_streams[_stream];
+        bool frameEnd = false;
+        {
+            std::lock_guard lock(stream.mutex);
+            frameEnd = stream.buffers[stream.head].frameEnd;
+            stream.head = (stream.head + 1) % stream.buffers.size();
+            --stream.filled;
+        }
+        stream.cond.notify_all();
+        _hasCurrent = false;
+
+        if(frameEnd) {
+            // the next frame is decompressed by the next thread
+            _stream = (_stream + 1) % _numOfStreams;
+        }
+    }
+
+    if(!_numOfStreams) {
+        return false;
+    }
+
+    auto& stream = *_streams[_stream];
+    std::unique_lock lock(stream.mutex);
+    stream.cond.wait(lock, [&stream]() { return stream.filled || stream.finished; });
+    if(!stream.filled) {
+        // the thread has no more frames, so there are no frames at all
+        return false;
+    }
+
+    const auto& buffer = stream.buffers[stream.head];
+    _pos = buffer.data.data();
+    _end = _pos + buffer.size;
+    _hasCurrent = true;
+
+    return true;
+}
+
+// read next line in file
+FileLineRef CompressedReader::readLine() {
+
+    // It is experimental code and so I don't do correct error handling for all cases
+    assert(_file >= 0);
+    assert(_buffer && _bufferSize > 1);
+
+    size_t consumed = 0;
+    bool newline = false;
+    startLine();
+
+    for(;;) {
+        if(_pos == _end && !nextBuffer()) {
+            // end of file, may be with the last line without newline
+            if(!consumed) {
+                return {};
+            }
+            break;
+        }
+
+        const char* eol = static_cast<const char*>(std::memchr(_pos, '\n', _end - _pos));
+        const size_t partSize = (eol ? eol : _end) - _pos;
+        const size_t copySize = appendToLine(_pos, partSize);
+        consumed += copySize;
+        _pos += copySize;
+
+        if(copySize < partSize) {
+            // line is longer than the buffer and there is no overflow arena,
+            // the rest is the next line
+            break;
+        }
+
+        if(eol) {
+            // skip newline symbol, it is stripped by takeLine
+            ++_pos;
+            ++consumed;
+            newline = true;
+            break;
+        }
+
+        // the line continues in the next decompressed buffer
+    }
+
+    advancePosition(consumed);
+    return takeLine(newline);
+}
+
+} // namespace fwc
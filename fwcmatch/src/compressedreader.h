@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "filereader.h"
+
+namespace fwc {
+
+/*
+Reader of compressed files, the format is detected by magic bytes: gzip
+(through zlib) and zstd (through libzstd if it's built with FWC_WITH_ZSTD).
+Other files are read as plain text, so the reader can be used for any file.
+Decompression runs on a separate pipeline thread which fills a ring of
+reusable buffers, lines are split out of decompressed buffers on the thread
+which calls readLine (e.g. the producer of a multithreading processor).
+A zstd file with several independent frames (e.g. made by pzstd or by
+concatenation of files) is decompressed in parallel: frames are
+given to threads in turn and every thread has its own ring of buffers,
+buffers are taken from the rings in the order of frames.
+Members of a gzip file are read one after another, padding or garbage after
+the last member is ignored like gzip does.
+Lines are copied into the line buffer because ring buffers are reused while
+blocks with lines can still be processed by other threads.
+Offsets are offsets in decompressed data. Seeking and follow mode are not
+supported.
+*/
+
+class CompressedReader final: public FileReader
+{
+public:
+
+    enum class Compression
+    {
+        None,
+        Gzip,
+        Zstd
+    };
+
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 1024*1024;
+    static constexpr size_t DEFAULT_QUEUE_DEPTH = 4;
+    static constexpr size_t DEFAULT_NUM_THREADS = 4;
+
+    explicit CompressedReader(size_t bufferSize = DEFAULT_BUFFER_SIZE,
+                                size_t queueDepth = DEFAULT_QUEUE_DEPTH,
+                                size_t numOfThreads = DEFAULT_NUM_THREADS);
+    ~CompressedReader();
+
+    // open file
+    void open(const std::string& filename) override;
+
+    // close file
+    void close() override;
+
+    bool needsBuffer() const override { return true; } ;
+
+    // read next line in file
+    // FileLineRef is used to avoid copying
+    FileLineRef readLine() override;
+
+    // compression of the open file
+    [[nodiscard]]
+    Compression compression() const noexcept { return _compression; }
+
+    // number of threads which decompress the open file
+    [[nodiscard]]
+    size_t numOfStreams() const noexcept { return _numOfStreams; }
+
+    // detect compression by magic bytes
+    [[nodiscard]]
+    static Compression detect(std::string_view data) noexcept;
+
+private:
+
+    struct Buffer
+    {
+        std::vector<char> data;
+        size_t            size     { 0 };
+        bool              frameEnd { false }; // the last buffer of a frame
+    };
+
+    // frames which are decompressed by one thread
+    struct Stream
+    {
+        std::vector<Buffer>     buffers;
+        size_t                  head     { 0 };
+        size_t                  filled   { 0 };
+        bool                    finished { false };
+        bool                    stopping { false };
+        std::mutex              mutex;
+        std::condition_variable cond;
+        std::thread             thread;
+    };
+
+    // split the file into frames which can be decompressed independently
+    void splitFrames();
+
+    // thread function, decompress every _numOfStreams-th frame
+    // beginning from the first one
+    void decompress(Stream& stream, size_t firstFrame);
+
+    // make the next decompressed buffer current, returns false at the end of file
+    bool nextBuffer();
+
+    void stopThreads();
+
+    std::vector<std::unique_ptr<Stream>> _streams;
+    std::vector<std::string_view>        _frames;
+    size_t      _numOfStreams { 0 };
+    size_t      _stream       { 0 }; // stream of the current buffer
+    bool        _hasCurrent   { false };
+    const char* _pos          { nullptr };
+    const char* _end          { nullptr };
+    Compression _compression  { Compression::None };
+    void*       _fileAddr     { nullptr };
+    size_t      _fileSize     { 0 };
+    int         _file         { -1 };
+    const size_t _ringBufferSize; // size of a buffer with decompressed data
+};
+
+} // namespace fwc
@@ -0,0 +1,24 @@
+#pragma once
+
+namespace fwc {
+
+// Runtime detection of CPU features to select SIMD implementations.
+// SSE2 is always available on x86-64 so there is no function for it.
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FWC_X86_SIMD 1
+#else
+#define FWC_X86_SIMD 0
+#endif
+
+[[nodiscard]]
+inline bool cpuHasAVX2() noexcept {
+#if FWC_X86_SIMD
+    static const bool result = __builtin_cpu_supports("avx2");
+    return result;
+#else
+    return false;
+#endif
+}
+
+} // namespace fwc
@@ -0,0 +1,77 @@
+#include <string_view>
+#include <algorithm>
+
+#include "dfawildcard.h"
+
+namespace fwc {
+
+// NFA for the whole text: '*' is a loop by any byte, '?' is any byte
+static NFA makeNFA(std::string_view pattern) {
+
+    NFA nfa;
+    NFA::ByteSet anyByte;
+    anyByte.set();
+
+    std::uint32_t next = nfa.addMatch();
+    for(auto it = pattern.rbegin(); it != pattern.rend(); ++it) {
+        if('*' == *it) {
+            auto split = nfa.addSplit(NFA::NONE, next);
+            nfa.setNext1(split, nfa.addBytes(anyByte, split));
+            next = split;
+            continue;
+        }
+
+        NFA::ByteSet bytes;
+        if('?' == *it) {
+            bytes = anyByte;
+        }
+        else {
+            bytes.set(static_cast<unsigned char>(*it));
+        }
+        next = nfa.addBytes(bytes, next);
+    }
+    nfa.setStart(next);
+
+    return nfa;
+}
+
+namespace {
+
+class DFACompiledPattern final: public CompiledPattern
+{
+public:
+    DFACompiledPattern(const std::string& pattern, size_t maxStates):
+        CompiledPattern(pattern),
+        _dfa(makeNFA(pattern), maxStates) {
+
+        // the longest part without wildcards, it refers to the own copy
+        _pattern = pattern;
+        std::string_view rest = _pattern;
+        while(!rest.empty()) {
+            auto size = std::min(rest.find_first_of("*?"), rest.size());
+            if(size > _literal.size()) {
+                _literal = rest.substr(0, size);
+            }
+            rest.remove_prefix(std::min(size + 1, rest.size()));
+        }
+    }
+
+    std::string_view requiredLiteral() const override { return _literal; }
+
+private:
+    bool isMatchImpl(const std::string_view& text) const override {
+        return _dfa.isMatch(text);
+    }
+
+    const LazyDFA    _dfa;
+    std::string      _pattern;
+    std::string_view _literal;
+};
+
+} // anonymous namespace
+
+CompiledPatternPtr DFAWildcardMatch::compile(const std::string& pattern) const {
+    return std::make_unique<DFACompiledPattern>(pattern, _maxStates);
+}
+
+} // namespace fwc
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+#include "wildcard.h"
+#include "lazydfa.h"
+
+namespace fwc {
+
+// Patterns are compiled into lazy DFA, so matching is linear time for any
+// pattern. Each compiled pattern has its own cache of states, 'maxStates'
+// limits it.
+// Thread safe
+class DFAWildcardMatch final: public WildcardMatch
+{
+public:
+    explicit DFAWildcardMatch(size_t maxStates = LazyDFA::DEFAULT_MAX_STATES):
+        _maxStates(maxStates) {
+    }
+
+    [[nodiscard]]
+    CompiledPatternPtr compile(const std::string& pattern) const override;
+
+private:
+    const size_t _maxStates;
+};
+
+} // namespace fwc
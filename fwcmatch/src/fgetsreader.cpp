@@ -29,6 +29,8 @@ void FGetsReader::open(const std::string& filename) {
         errorAndStop("File opening failed");
     }
 
+    resetPosition();
+
     //setvbuf(_file , NULL , _IOFBF , 1024*4);
 }
 
@@ -51,20 +53,74 @@ FileLineRef FGetsReader::readLine() {
         return {};
     }
 
-    // strip newline symbol
-    size_t lineSize = 0;
     const char* eol = strchr(_buffer, '\n');
+    size_t consumed = eol ? eol - _buffer : strnlen(_buffer, _bufferSize);
+    FileLineRef line { _buffer, consumed };
+
+    if(!eol && _overflow && consumed == _bufferSize - 1) {
+        // the line is longer than the buffer, it's moved into the arena
+        _overflow->startLine();
+        _overflow->append(_buffer, consumed);
+        while(!eol && fgets(_buffer, _bufferSize, _file)) {
+            eol = strchr(_buffer, '\n');
+            const size_t partSize = eol ? eol - _buffer : strnlen(_buffer, _bufferSize);
+            _overflow->append(_buffer, partSize);
+            consumed += partSize;
+        }
+        line = _overflow->line();
+    }
+
     if(eol) {
-        if(eol != _buffer && *(eol-1) == '\r') {
-            --eol;
+        // strip newline symbol
+        advancePosition(consumed + 1);
+        if(!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
         }
-        lineSize = eol - _buffer;
+        return line;
     }
-    else {
-        lineSize = strnlen(_buffer, _bufferSize);
+
+    if(followMode() && feof(_file)) {
+        // return the incomplete last line into the file and
+        // wait for the rest of it
+        if(fseeko(_file, -static_cast<off_t>(consumed), SEEK_CUR) != 0) {
+            errorAndStop("fseek");
+        }
+        return {};
     }
+    advancePosition(consumed);
+
+    return line;
+}
+
+bool FGetsReader::seek(size_t offset) {
 
-    return { _buffer, lineSize };
+    assert(_file);
+
+    const bool inLine = offset > 0;
+    if(fseeko(_file, inLine ? offset - 1 : 0, SEEK_SET) != 0) {
+        errorAndStop("fseek");
+    }
+
+    if(inLine) {
+        // skip the rest of the line (or only newline before the offset)
+        int ch;
+        while((ch = getc(_file)) != EOF && ch != '\n') {
+        }
+    }
+
+    auto pos = ftello(_file);
+    if(pos < 0) {
+        errorAndStop("ftell");
+    }
+
+    resetPosition(pos);
+    return true;
+}
+
+bool FGetsReader::refresh() {
+    assert(_file);
+    clearerr(_file);
+    return true;
 }
 
 } // namespace fwc
@@ -25,6 +25,12 @@ class FGetsReader final: public FileReader
     // FileLineRef is used to avoid copying
     FileLineRef readLine() override;
 
+    bool seek(size_t offset) override;
+    bool canSeek() const override { return true; }
+
+    // reset end of file state to read appended data
+    bool refresh() override;
+
 private:
     FILE*  _file { nullptr };
 };
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstddef>
+#include <cstring>
 #include <string>
+#include <algorithm>
 
 #include "noncopyable.h"
 #include "linesblock.h"
@@ -21,15 +23,119 @@ class FileReader: private noncopyable
 
     virtual bool needsBuffer() const = 0;
 
+    // false if read lines are valid only until the next block is read, then
+    // a block can't be queued or kept while other blocks are read
+    [[nodiscard]]
+    virtual bool keepsLines() const { return true; }
+
     void setBuffer(char* buffer, size_t bufferSize);
 
+    // Lines which are longer than the buffer are moved into the arena and
+    // stay one line. Without it the rest of such a line is the next line.
+    void setOverflow(OverflowArena* overflow) noexcept { _overflow = overflow; }
+
     // read next line in file
     // FileLineRef is used to avoid copying
     virtual FileLineRef readLine() = 0;
 
+    // Read up to 'maxLines' lines into the block at once (the block is
+    // cleared before), lines which begin at 'endOffset' or after it are not
+    // read. Returns false if reader doesn't support it, readLine is used then.
+    virtual bool readLines(LinesBlock& /*block*/, size_t /*maxLines*/,
+                                size_t /*endOffset*/) { return false; }
+
+    // The same for blocks with compact layout, it's the only way to read them
+    virtual bool readLines(CompactLinesBlock& /*block*/, size_t /*maxLines*/,
+                                size_t /*endOffset*/) { return false; }
+
+    // byte offset of the next line in file
+    [[nodiscard]]
+    size_t offset() const noexcept { return _offset; }
+
+    // number of lines read from file
+    [[nodiscard]]
+    size_t linesRead() const noexcept { return _linesRead; }
+
+    // In follow mode the last line without newline is not returned, it is
+    // kept in file until its newline is appended. It's used for growing files.
+    void setFollowMode(bool follow) noexcept { _followMode = follow; }
+
+    [[nodiscard]]
+    bool followMode() const noexcept { return _followMode; }
+
+    // Make data appended to the open file since opening or the previous call
+    // available for reading. Returns false if reader doesn't support it.
+    virtual bool refresh() { return false; }
+
+    // Move to the first line which begins at the offset or after it, it is
+    // used to read a file by byte ranges. Numbers of lines are counted from
+    // this place. Returns false if reader doesn't support it.
+    virtual bool seek(size_t /*offset*/) { return false; }
+
+    // true if 'seek' is supported, offsets are positions in the file itself
+    [[nodiscard]]
+    virtual bool canSeek() const { return false; }
+
+    // It is called before reading of each lines block. A reader can end
+    // a block earlier (readLine returns null line) if the block would
+    // refer to memory which the reader has to reuse.
+    virtual void startBlock() {}
+
 protected:
-    char*  _buffer     { nullptr };
-    size_t _bufferSize { 0 };
+    // it must be called in open() and seek()
+    void resetPosition(size_t offset = 0) noexcept {
+        _offset = offset;
+        _linesRead = 0;
+    }
+
+    // it must be called for each read line (or lines) with number of
+    // consumed bytes including newline symbols
+    void advancePosition(size_t bytes, size_t lines = 1) noexcept {
+        _offset += bytes;
+        _linesRead += lines;
+    }
+
+    // Helpers for readers which copy a line into the buffer by parts
+    void startLine() noexcept {
+        _lineSize = 0;
+        _lineInOverflow = false;
+    }
+
+    // Returns number of copied bytes, it is less than 'size' only if the
+    // buffer is full and there is no overflow arena
+    size_t appendToLine(const char* data, size_t size) {
+        if(!_lineInOverflow && size <= _bufferSize - _lineSize) {
+            std::memcpy(_buffer + _lineSize, data, size);
+            _lineSize += size;
+            return size;
+        }
+        return appendToOverflow(data, size);
+    }
+
+    // the line which is copied by parts, 'newline' means that it ended with
+    // newline so '\r' is stripped
+    [[nodiscard]]
+    FileLineRef takeLine(bool newline) const noexcept {
+        FileLineRef line = _lineInOverflow ? _overflow->line() : FileLineRef(_buffer, _lineSize);
+        if(newline && !line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        return line;
+    }
+
+    char*          _buffer     { nullptr };
+    size_t         _bufferSize { 0 };
+    OverflowArena* _overflow   { nullptr };
+
+private:
+
+    size_t appendToOverflow(const char* data, size_t size);
+
+    size_t _offset     { 0 };
+    size_t _linesRead  { 0 };
+    bool   _followMode { false };
+    size_t _lineSize   { 0 };
+    bool   _lineInOverflow { false };
 };
 
 inline void FileReader::setBuffer(char* buffer, size_t bufferSize) {
@@ -37,6 +143,27 @@ inline void FileReader::setBuffer(char* buffer, size_t bufferSize) {
     _bufferSize = bufferSize;
 }
 
+inline size_t FileReader::appendToOverflow(const char* data, size_t size) {
+
+    if(!_overflow) {
+        // the rest of the line is the next line
+        const size_t copySize = std::min(size, _bufferSize - _lineSize);
+        std::memcpy(_buffer + _lineSize, data, copySize);
+        _lineSize += copySize;
+        return copySize;
+    }
+
+    if(!_lineInOverflow) {
+        // the line is longer than the buffer
+        _overflow->startLine();
+        _overflow->append(_buffer, _lineSize);
+        _lineInOverflow = true;
+    }
+
+    _overflow->append(data, size);
+    return size;
+}
+
 // RAII for open/close of FileReader
 class ScopedFileOpener final: private noncopyable {
 public:
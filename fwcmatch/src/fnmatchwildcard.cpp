@@ -1,20 +1,43 @@
-
 #include <fnmatch.h>
 
 #include "fnmatchwildcard.h"
 
 namespace fwc {
 
-thread_local std::string FNMatch::_text;
+namespace {
+
+class FNCompiledPattern final: public CompiledPattern
+{
+public:
+    explicit FNCompiledPattern(const std::string& pattern):
+        CompiledPattern(pattern), _pattern(pattern) {
+    }
+
+private:
+    bool isMatchImpl(const std::string_view& text) const override;
+
+    const std::string _pattern;
+
+    // used as a cache to reduce number of memory allocation/deallocation
+    thread_local static std::string _text;
+};
 
-bool FNMatch::isMatchImpl(const std::string_view& text, const std::string& pattern) const {
+thread_local std::string FNCompiledPattern::_text;
+
+bool FNCompiledPattern::isMatchImpl(const std::string_view& text) const {
 
     // fnmatch expects C string terminated by a null character '\0' while we
     // have no such a string in the 'text' so I have to make a copy from the
     // string_view to a string with a null character '\0'.
     _text = text;
 
-    return 0 == fnmatch(pattern.c_str(), _text.c_str(), FNM_NOESCAPE);
+    return 0 == fnmatch(_pattern.c_str(), _text.c_str(), FNM_NOESCAPE);
+}
+
+} // anonymous namespace
+
+CompiledPatternPtr FNMatch::compile(const std::string& pattern) const {
+    return std::make_unique<FNCompiledPattern>(pattern);
 }
 
-} // namespace fwc
\ No newline at end of file
+} // namespace fwc
@@ -4,15 +4,15 @@
 
 namespace fwc {
 
+// POSIX fnmatch (without escapes), each text is copied to get a C string.
+// It's kept as a reference for checks, GlobMatch has the same semantics
+// without copying.
 // Thread safe
 class FNMatch final: public WildcardMatch
 {
-private:
-    bool isMatchImpl(const std::string_view& text,
-                                const std::string& pattern) const override;
-
-    // used as a cache to reduce number of memory allocation/deallocation
-    thread_local static std::string _text;
+public:
+    [[nodiscard]]
+    CompiledPatternPtr compile(const std::string& pattern) const override;
 };
 
-} // namespace fwc
\ No newline at end of file
+} // namespace fwc
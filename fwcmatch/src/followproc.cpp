@@ -0,0 +1,180 @@
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <filesystem>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+
+#include "utils.h"
+#include "proctools.h"
+#include "followproc.h"
+
+namespace fwc {
+
+static constexpr size_t BLOCK_SIZE = 4*1024;
+
+// Inotify can miss changes (e.g. on network file systems),
+// so file is checked with this period anyway.
+static constexpr int CHECK_PERIOD_MS = 1000;
+
+static constexpr uint32_t WATCH_MASK = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+                                IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+FollowProcessor::FollowProcessor(BlockLimits limits, bool needsBuffer) {
+
+    assert(limits.maxLines > 0);
+    _linesBlock.alloc(limits, needsBuffer, BLOCK_SIZE);
+    _matched.reserve(limits.maxLines);
+
+    _inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(-1 == _inotifyFd) {
+        errorAndStop("inotify_init1");
+    }
+
+    _stopFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(-1 == _stopFd) {
+        errorAndStop("eventfd");
+    }
+}
+
+FollowProcessor::~FollowProcessor() {
+    ::close(_inotifyFd);
+    ::close(_stopFd);
+}
+
+void FollowProcessor::stop() {
+
+    _stop.store(true, std::memory_order_release);
+
+    uint64_t value = 1;
+    [[maybe_unused]] auto res = ::write(_stopFd, &value, sizeof(value));
+}
+
+size_t FollowProcessor::processNewLines(FileReader& freader, const CompiledPattern& cpattern,
+                                                        LineSink* sink, size_t& found) {
+    size_t linesRead = 0;
+    for(;;) {
+        proctools::readInLinesBlock(freader, _linesBlock);
+        if(_linesBlock.lines().empty()) {
+            // no complete lines yet
+            break;
+        }
+
+        linesRead += _linesBlock.lines().size();
+        found += proctools::filterBlock(cpattern, _linesBlock, sink, _matched);
+    }
+
+    return linesRead;
+}
+
+void FollowProcessor::waitForChanges() {
+
+    struct pollfd fds[2] = {
+        { _inotifyFd, POLLIN, 0 },
+        { _stopFd,    POLLIN, 0 },
+    };
+
+    auto res = ::poll(fds, 2, CHECK_PERIOD_MS);
+    if(res < 0 && errno != EINTR) {
+        errorAndStop("poll");
+    }
+
+    // events are only a signal to check the file, so they are just dropped
+    alignas(struct inotify_event) char events[4096];
+    while(::read(_inotifyFd, events, sizeof(events)) > 0) {
+    }
+}
+
+size_t FollowProcessor::execute(FileReader& freader, const std::string& filename,
+                            const CompiledPattern& cpattern, const Progress& progress,
+                            LineSink* sink) {
+
+    // the directory is watched to see replacement of the file
+    auto dirname = std::filesystem::path(filename).parent_path();
+    if(dirname.empty()) {
+        dirname = std::filesystem::path(".");
+    }
+
+    auto wd = ::inotify_add_watch(_inotifyFd, dirname.c_str(), WATCH_MASK);
+    if(-1 == wd) {
+        errorAndStop("inotify_add_watch");
+    }
+
+    const bool followMode = freader.followMode();
+    freader.setFollowMode(true);
+
+    ScopedFileOpener fopener(freader, filename);
+    if(!freader.refresh()) {
+        errorAndStop("File reader doesn't support follow mode", false);
+    }
+
+    struct stat sb;
+    if(::stat(filename.c_str(), &sb) == -1) {
+        errorAndStop("stat");
+    }
+    auto inode = sb.st_ino;
+
+    size_t found = 0;
+    size_t linesRead = 0;
+    size_t reportedLines = 0;
+    for(;;) {
+
+        linesRead += processNewLines(freader, cpattern, sink, found);
+        if(linesRead != reportedLines) {
+            reportedLines = linesRead;
+            if(progress && !progress(found, linesRead)) {
+                break;
+            }
+        }
+
+        if(_stop.load(std::memory_order_acquire)) {
+            break;
+        }
+
+        waitForChanges();
+
+        if(::stat(filename.c_str(), &sb) == -1) {
+            // file is removed or renamed and a new one isn't created yet,
+            // the old one can still be written
+            freader.refresh();
+            continue;
+        }
+
+        if(sb.st_ino != inode) {
+            // file is replaced (rotated), read the rest of the old one
+            // including its last line without newline
+            freader.refresh();
+            freader.setFollowMode(false);
+            linesRead += processNewLines(freader, cpattern, sink, found);
+            freader.setFollowMode(true);
+
+            freader.close();
+            freader.open(filename);
+            inode = sb.st_ino;
+        }
+        else if(static_cast<size_t>(sb.st_size) < freader.offset()) {
+            // file is truncated, its old content is lost
+            freader.close();
+            freader.open(filename);
+        }
+        else {
+            freader.refresh();
+        }
+    }
+
+    ::inotify_rm_watch(_inotifyFd, wd);
+    freader.setFollowMode(followMode);
+
+    // prepare for the next execution
+    uint64_t value = 0;
+    [[maybe_unused]] auto res = ::read(_stopFd, &value, sizeof(value));
+    _stop.store(false, std::memory_order_release);
+
+    return found;
+}
+
+} // namespace fwc
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <atomic>
+#include <functional>
+
+#include "noncopyable.h"
+#include "linesblock.h"
+#include "linesink.h"
+#include "wildcard.h"
+#include "filereader.h"
+
+namespace fwc {
+
+/*
+This class processes a growing file like 'tail -f' does. When the end of
+the file is reached it waits for changes with inotify and reads only new
+lines, an incomplete last line is kept by the reader in follow mode until its
+newline is appended. If the file is replaced (its inode changes) or truncated,
+the rest of the old file is read and the new file is opened from the beginning.
+Running counts are reported with a callback after each portion of new lines.
+*/
+
+class FollowProcessor final: private noncopyable
+{
+public:
+
+    // It gets total number of found lines and total number of read lines,
+    // processing is stopped if it returns false.
+    using Progress = std::function<bool(size_t found, size_t linesRead)>;
+
+    FollowProcessor(BlockLimits limits, bool needsBuffer);
+    ~FollowProcessor();
+
+    // It returns only when the progress callback returns false or 'stop' is
+    // called. The reader must support 'refresh'.
+    size_t execute(FileReader& freader, const std::string& filename,
+                    const CompiledPattern& cpattern, const Progress& progress,
+                    LineSink* sink = nullptr);
+
+    size_t execute(FileReader& freader, const std::string& filename,
+                    const WildcardMatch& wcmatch, const std::string& pattern,
+                    const Progress& progress, LineSink* sink = nullptr) {
+        return execute(freader, filename, *wcmatch.compile(pattern), progress, sink);
+    }
+
+    // it can be called from any thread
+    void stop();
+
+private:
+
+    // read and filter lines until there are no complete lines
+    // Returns number of read lines
+    size_t processNewLines(FileReader& freader, const CompiledPattern& cpattern,
+                                                    LineSink* sink, size_t& found);
+
+    // wait for changes in the directory of the file or for stop
+    void waitForChanges();
+
+    LinesBlock        _linesBlock;
+    MatchedLines      _matched;
+    std::atomic<bool> _stop { false };
+    int               _inotifyFd { -1 };
+    int               _stopFd    { -1 };
+};
+
+} // namespace fwc
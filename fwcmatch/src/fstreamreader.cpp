@@ -4,6 +4,7 @@
 #include <cstring>
 #include <iostream>
 #include <string>
+#include <limits>
 
 #include "utils.h"
 #include "fstreamreader.h"
@@ -28,6 +29,8 @@ void FStreamReader::open(const std::string& filename) {
     if(!_stream) {
         errorAndStop("File opening failed", false);
     }
+
+    resetPosition();
 }
 
 // close file
@@ -37,12 +40,35 @@ void FStreamReader::close() {
     }
 }
 
-// read next line in file
-FileLineRef FStreamReader::readLine() {
+bool FStreamReader::seek(size_t offset) {
 
-    // It is experimental code and so I don't do correct error handling for all cases
     assert(_stream.is_open());
-    assert(_buffer && _bufferSize > 1);
+
+    _stream.clear();
+    _stream.seekg(offset > 0 ? offset - 1 : 0);
+    if(offset > 0) {
+        // skip the rest of the line (or only newline before the offset)
+        _stream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+
+    if(_stream.eof()) {
+        // 'seekg' doesn't work after eof, so the position is the end of file
+        _stream.clear();
+        _stream.seekg(0, std::ios::end);
+    }
+
+    auto pos = _stream.tellg();
+    if(pos < 0) {
+        errorAndStop("Seeking in file failed", false);
+    }
+
+    resetPosition(pos);
+    return true;
+}
+
+// Read a part of line into the buffer and add number of extracted symbols
+// to 'consumed'. Returns true if the part ends with newline.
+bool FStreamReader::readPart(size_t& consumed) {
 
     // I don't use std::getline because it cannot be used with char* buffer
     _stream.getline(_buffer, _bufferSize);
@@ -51,27 +77,62 @@ FileLineRef FStreamReader::readLine() {
         errorAndStop("I/O error while reading", false);
     }
 
-    if(_stream.eof()) {
-        return {};
+    consumed += _stream.gcount();
+
+    if(_stream.fail() && !_stream.eof()) {
+        // basic_istream::getline sets failbit if the buffer is full before
+        // the delimiter, the rest of the line can be read by the next call
+        _stream.clear();
+        return false;
     }
 
-    size_t lineSize = _stream.gcount();
-    if(!lineSize) {
-        errorAndStop("Logical error while reading", false);
+    // without eof the delimiter '\n' is found
+    return !_stream.eof();
+}
+
+// read next line in file
+FileLineRef FStreamReader::readLine() {
+
+    // It is experimental code and so I don't do correct error handling for all cases
+    assert(_stream.is_open());
+    assert(_buffer && _bufferSize > 1);
+
+    size_t consumed = 0;
+    bool newline = readPart(consumed);
+    if(!consumed) {
+        // end of file
+        return {};
     }
 
-    if(!_stream.fail()) {
-        // basic_istream::getline set failbit if a delimiter was not found
-        // So here we found the delimiter '\n'
+    FileLineRef line { _buffer, consumed - newline };
 
-        --lineSize;
-        const char* eol = _buffer + lineSize;
-        if(eol != _buffer && *(eol-1) == '\r') {
-            --lineSize;
+    if(!newline && _overflow && !_stream.eof()) {
+        // the line is longer than the buffer, it's moved into the arena
+        _overflow->startLine();
+        _overflow->append(_buffer, consumed);
+        while(!newline && !_stream.eof()) {
+            const size_t prevConsumed = consumed;
+            newline = readPart(consumed);
+            _overflow->append(_buffer, consumed - prevConsumed - newline);
         }
+        line = _overflow->line();
+    }
+
+    if(!newline && _stream.eof() && followMode()) {
+        // return the incomplete last line into the file and
+        // wait for the rest of it
+        _stream.clear();
+        _stream.seekg(-static_cast<std::streamoff>(consumed), std::ios::cur);
+        return {};
+    }
+
+    advancePosition(consumed);
+
+    if(newline && !line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
     }
 
-    return { _buffer, lineSize };
+    return line;
 }
 
-} // namespace fwc
\ No newline at end of file
+} // namespace fwc
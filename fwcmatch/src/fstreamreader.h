@@ -24,7 +24,12 @@ class FStreamReader final: public FileReader
     // FileLineRef is used to avoid copying
     FileLineRef readLine() override;
 
+    bool seek(size_t offset) override;
+    bool canSeek() const override { return true; }
+
 private:
+    bool readPart(size_t& consumed);
+
     std::ifstream _stream;
 };
 
@@ -0,0 +1,293 @@
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <string_view>
+#include <vector>
+#include <fnmatch.h>
+
+#include "charclass.h"
+#include "utils.h"
+#include "globwildcard.h"
+
+namespace fwc {
+
+namespace {
+
+/*
+The pattern is compiled into tokens: bytes, sets of bytes ('?', '[...]')
+and stars. With FNM_PATHNAME '/' can be matched only by '/', so the pattern
+and the text are split by '/' into components which are matched one by one.
+A component is matched from the left to the right, only the last star is
+remembered: if the rest doesn't match the star takes one more byte. An
+earlier star never needs to take more, because the last one can take the
+same bytes instead. After a star the text is skipped with memchr to the
+next ordinary byte of the pattern.
+Bytes are compared through a fold table (identity or lower case), so texts
+are never copied.
+*/
+
+class GlobCompiledPattern final: public CompiledPattern
+{
+public:
+    GlobCompiledPattern(const std::string& pattern, int flags);
+
+    std::string_view requiredLiteral() const override { return _literal; }
+
+private:
+
+    struct Token final {
+        enum class Kind: std::uint8_t {
+            BYTE,  // the byte, in lower case with FNM_CASEFOLD
+            SET,   // the byte is in the set
+            STAR,  // any number of bytes
+            SLASH  // the end of a component with FNM_PATHNAME
+        };
+
+        Kind          kind;
+        unsigned char byte { 0 };
+        std::uint32_t set  { 0 };  // index in '_sets'
+    };
+
+    constexpr static size_t NONE = SIZE_MAX;
+
+    bool isMatchImpl(const std::string_view& text) const override;
+
+    void parse(std::string_view pattern);
+
+    // find the longest part of ordinary bytes
+    void findRequiredLiteral();
+
+    bool matchComponent(size_t p, size_t pEnd, const char* t, const char* tEnd) const;
+
+    // the first position from 't' where the token can be matched
+    const char* skipTo(size_t p, const char* t, const char* tEnd) const;
+
+    // The byte is a leading period which must be matched by '.' itself
+    bool isLeadingPeriod(const char* t, const char* componentBegin) const noexcept {
+        return _period && t == componentBegin && '.' == *t;
+    }
+
+    const bool                    _escapes;
+    const bool                    _pathName;
+    const bool                    _period;
+    const bool                    _caseFold;
+    bool                          _neverMatches { false };
+    std::array<unsigned char, 256> _fold;
+    std::vector<Token>            _tokens;
+    std::vector<ByteSet>          _sets;
+    std::vector<size_t>           _componentEnds; // positions of SLASH tokens and the end
+    std::string                   _literal;
+};
+
+GlobCompiledPattern::GlobCompiledPattern(const std::string& pattern, int flags):
+    CompiledPattern(pattern),
+    _escapes(!(flags & FNM_NOESCAPE)),
+    _pathName(flags & FNM_PATHNAME),
+    _period(flags & FNM_PERIOD),
+    _caseFold(flags & FNM_CASEFOLD) {
+
+    for(size_t c = 0; c < _fold.size(); ++c) {
+        _fold[c] = _caseFold ? CASE_FOLD[c] : c;
+    }
+
+    parse(pattern);
+
+    for(size_t p = 0; p < _tokens.size(); ++p) {
+        if(_tokens[p].kind == Token::Kind::SLASH) {
+            _componentEnds.push_back(p);
+        }
+    }
+    _componentEnds.push_back(_tokens.size());
+
+    findRequiredLiteral();
+}
+
+void GlobCompiledPattern::parse(std::string_view pattern) {
+
+    auto addByte = [&](unsigned char c) {
+        if('/' == c && _pathName) {
+            _tokens.push_back({ Token::Kind::SLASH, c });
+            return;
+        }
+        _tokens.push_back({ Token::Kind::BYTE, _fold[c] });
+    };
+
+    auto addSet = [&](const ByteSet& set) {
+        _tokens.push_back({ Token::Kind::SET, 0, static_cast<std::uint32_t>(_sets.size()) });
+        _sets.push_back(set);
+    };
+
+    for(size_t i = 0; i < pattern.size(); ++i) {
+        const char c = pattern[i];
+        if('*' == c) {
+            _tokens.push_back({ Token::Kind::STAR });
+        }
+        else if('?' == c) {
+            addSet(ByteSet().set());
+        }
+        else if('[' == c) {
+            ByteSet set;
+            // with FNM_PATHNAME it never meets '/' in texts of components
+            auto next = parseBracket(pattern, i, _escapes, _caseFold, set);
+            if(next == std::string_view::npos) {
+                addByte(c);
+                continue;
+            }
+            addSet(set);
+            i = next - 1;
+        }
+        else if('\\' == c && _escapes) {
+            if(i + 1 == pattern.size()) {
+                // fnmatch never matches a pattern with a trailing '\'
+                _neverMatches = true;
+                return;
+            }
+            if(_pathName && '/' == pattern[i + 1] &&
+                        !_tokens.empty() && _tokens.back().kind == Token::Kind::STAR) {
+                // fnmatch stops a star before '/' and never checks '\/' there
+                _neverMatches = true;
+                return;
+            }
+            addByte(pattern[++i]);
+        }
+        else {
+            addByte(c);
+        }
+    }
+}
+
+void GlobCompiledPattern::findRequiredLiteral() {
+
+    if(_neverMatches) {
+        return;
+    }
+
+    std::string current;
+    for(size_t p = 0; p <= _tokens.size(); ++p) {
+        const bool isFixed = p < _tokens.size() &&
+                    _tokens[p].kind != Token::Kind::STAR &&
+                    _tokens[p].kind != Token::Kind::SET &&
+                    !(_caseFold && isAsciiLetter(_tokens[p].byte));
+        if(isFixed) {
+            current.push_back(_tokens[p].byte);
+            continue;
+        }
+        if(current.size() > _literal.size()) {
+            _literal = current;
+        }
+        current.clear();
+    }
+}
+
+const char* GlobCompiledPattern::skipTo(size_t p, const char* t, const char* tEnd) const {
+
+    auto const& token = _tokens[p];
+    if(token.kind != Token::Kind::BYTE || t >= tEnd ||
+                                        (_caseFold && isAsciiLetter(token.byte))) {
+        return t;
+    }
+
+    auto found = static_cast<const char*>(std::memchr(t, token.byte, tEnd - t));
+    return found ? found : tEnd;
+}
+
+bool GlobCompiledPattern::matchComponent(size_t p, size_t pEnd,
+                                            const char* t, const char* tEnd) const {
+
+    const char* begin = t;
+
+    size_t      starP = NONE; // the token after the last star
+    const char* starT = nullptr;
+    while(true) {
+        if(p < pEnd && _tokens[p].kind == Token::Kind::STAR) {
+            if(t < tEnd && isLeadingPeriod(t, begin)) {
+                return false;
+            }
+            while(p < pEnd && _tokens[p].kind == Token::Kind::STAR) {
+                ++p;
+            }
+            if(p == pEnd) {
+                // a trailing star takes the rest of the component
+                return true;
+            }
+            starP = p;
+            starT = t = skipTo(p, t, tEnd);
+            continue;
+        }
+
+        if(t == tEnd) {
+            // stars can only take more bytes
+            return p == pEnd;
+        }
+
+        if(p < pEnd) {
+            auto const& token = _tokens[p];
+            const auto c = static_cast<unsigned char>(*t);
+            const bool matched = token.kind == Token::Kind::BYTE ?
+                        _fold[c] == token.byte :
+                        _sets[token.set][c] && !isLeadingPeriod(t, begin);
+            if(matched) {
+                ++p;
+                ++t;
+                continue;
+            }
+        }
+
+        if(starP == NONE) {
+            return false;
+        }
+
+        // the last star takes one more byte
+        p = starP;
+        starT = t = skipTo(p, starT + 1, tEnd);
+    }
+}
+
+bool GlobCompiledPattern::isMatchImpl(const std::string_view& text) const {
+
+    if(_neverMatches) {
+        return false;
+    }
+
+    const char* t   = text.data();
+    const char* end = t + text.size();
+
+    if(!_pathName) {
+        return matchComponent(0, _tokens.size(), t, end);
+    }
+
+    size_t p = 0;
+    for(size_t idx = 0; idx < _componentEnds.size(); ++idx) {
+        const bool isLast = idx + 1 == _componentEnds.size();
+        auto slash = static_cast<const char*>(std::memchr(t, '/', end - t));
+        if(isLast != !slash) {
+            // numbers of components are different
+            return false;
+        }
+
+        const char* tEnd = slash ? slash : end;
+        if(!matchComponent(p, _componentEnds[idx], t, tEnd)) {
+            return false;
+        }
+
+        p = _componentEnds[idx] + 1;
+        t = tEnd + 1;
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+GlobMatch::GlobMatch(int flags): _flags(flags) {
+    if(flags & ~(FNM_NOESCAPE | FNM_PATHNAME | FNM_PERIOD | FNM_CASEFOLD)) {
+        errorAndStop("Unsupported flags of GlobMatch", false);
+    }
+}
+
+CompiledPatternPtr GlobMatch::compile(const std::string& pattern) const {
+    return std::make_unique<GlobCompiledPattern>(pattern, _flags);
+}
+
+} // namespace fwc
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "wildcard.h"
+
+namespace fwc {
+
+// Replacement of fnmatch which works with string_view without copying of
+// texts. 'flags' are a combination of FNM_NOESCAPE, FNM_PATHNAME, FNM_PERIOD
+// and FNM_CASEFOLD from <fnmatch.h> with the same meaning (the C locale).
+// Thread safe
+class GlobMatch final: public WildcardMatch
+{
+public:
+    explicit GlobMatch(int flags = 0);
+
+    [[nodiscard]]
+    CompiledPatternPtr compile(const std::string& pattern) const override;
+
+private:
+    const int _flags;
+};
+
+} // namespace fwc
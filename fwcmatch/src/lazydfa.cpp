@@ -0,0 +1,290 @@
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+
+#include "cpufeatures.h"
+#include "lazydfa.h"
+#include "literalsearch.h"
+
+#if FWC_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace fwc {
+
+LazyDFA::LazyDFA(NFA&& nfa, size_t maxStates): _nfa(std::move(nfa)) {
+
+    assert(_nfa.start() < _nfa.states().size());
+    assert(maxStates > 0);
+
+    computeClasses();
+
+    // offsets of states must fit into transitions, the state 0 is not used
+    _maxStates = std::min(maxStates + 1, OFFSET_MASK / _numClasses);
+    _numOfStates = 1;
+    _table.reset(new std::atomic<std::uint32_t>[_maxStates * _numClasses]());
+    _accepting.reset(new bool[_maxStates]());
+    _accels.reset(new Accel[_maxStates]);
+    _sets.reset(new StateSet[_maxStates]);
+
+    StateSet start;
+    ++_scratch.mark;
+    _scratch.marks.assign(_nfa.states().size(), 0);
+    addClosure(_nfa.start(), _scratch, start);
+    std::sort(start.begin(), start.end());
+
+    _start = findOrAddState(std::move(start));
+    assert(_start);
+}
+
+size_t LazyDFA::numOfStates() const {
+    std::lock_guard lock(_mutex);
+    return _numOfStates - 1;
+}
+
+void LazyDFA::computeClasses() {
+
+    // refine classes by each set of bytes: bytes of one class must be
+    // either all in the set or all not in it
+    _classes.assign(256, 0);
+    _numClasses = 1;
+    for(auto const& state: _nfa.states()) {
+        if(state.kind != NFA::Kind::BYTES) {
+            continue;
+        }
+
+        std::vector<int> inSet(_numClasses, -1);
+        std::vector<int> outSet(_numClasses, -1);
+        _numClasses = 0;
+        for(size_t c = 0; c < _classes.size(); ++c) {
+            auto& mapped = state.bytes[c] ? inSet[_classes[c]] : outSet[_classes[c]];
+            if(mapped < 0) {
+                mapped = _numClasses++;
+            }
+            _classes[c] = mapped;
+        }
+    }
+
+    _representatives.assign(_numClasses, 0);
+    for(size_t c = _classes.size(); c-- > 0; ) {
+        _representatives[_classes[c]] = c;
+    }
+}
+
+void LazyDFA::addClosure(std::uint32_t state, Scratch& scratch, StateSet& set) const {
+
+    // only states which consume bytes or match are kept in sets
+    auto const& states = _nfa.states();
+    scratch.stack.push_back(state);
+    while(!scratch.stack.empty()) {
+        const auto current = scratch.stack.back();
+        scratch.stack.pop_back();
+        if(current == NFA::NONE || scratch.marks[current] == scratch.mark) {
+            continue;
+        }
+        scratch.marks[current] = scratch.mark;
+
+        auto const& nfaState = states[current];
+        if(nfaState.kind == NFA::Kind::SPLIT) {
+            scratch.stack.push_back(nfaState.next2);
+            scratch.stack.push_back(nfaState.next1);
+            continue;
+        }
+        set.push_back(current);
+    }
+}
+
+LazyDFA::StateSet LazyDFA::step(const StateSet& from, unsigned char byte,
+                                                    Scratch& scratch) const {
+
+    if(++scratch.mark == 0) {
+        // marks of old steps could be met again
+        std::fill(scratch.marks.begin(), scratch.marks.end(), 0);
+        scratch.mark = 1;
+    }
+
+    StateSet to;
+    auto const& states = _nfa.states();
+    for(auto state: from) {
+        auto const& nfaState = states[state];
+        if(nfaState.kind == NFA::Kind::BYTES && nfaState.bytes[byte]) {
+            addClosure(nfaState.next1, scratch, to);
+        }
+    }
+    std::sort(to.begin(), to.end());
+
+    return to;
+}
+
+bool LazyDFA::isAccepting(const StateSet& set) const {
+    auto const& states = _nfa.states();
+    return std::any_of(set.begin(), set.end(), [&](auto state) {
+        return states[state].kind == NFA::Kind::MATCH;
+    });
+}
+
+bool LazyDFA::acceptsAll(const StateSet& set, Scratch& scratch) const {
+
+    if(!isAccepting(set)) {
+        return false;
+    }
+
+    for(auto byte: _representatives) {
+        auto next = step(set, byte, scratch);
+        if(!std::includes(next.begin(), next.end(), set.begin(), set.end())) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// skipping doesn't pay off if the state is left too often, e.g. by 'e'
+constexpr static std::uint8_t MAX_ACCEL_RANK = 200;
+
+bool LazyDFA::findAccel(const StateSet& set, Scratch& scratch, Accel& accel) const {
+
+    accel.size = 0;
+    for(size_t cls = 0; cls < _numClasses; ++cls) {
+        if(step(set, _representatives[cls], scratch) == set) {
+            continue;
+        }
+
+        // all bytes of the class leave the state
+        for(size_t c = 0; c < _classes.size(); ++c) {
+            if(_classes[c] != cls) {
+                continue;
+            }
+            if(accel.size == std::size(accel.bytes) || byteRank(c) >= MAX_ACCEL_RANK) {
+                return false;
+            }
+            accel.bytes[accel.size++] = c;
+        }
+    }
+
+    return true;
+}
+
+const char* LazyDFA::skip(std::uint32_t offset, const char* pos, const char* end) const {
+
+    auto const& accel = _accels[offset / _numClasses];
+    if(!accel.size) {
+        // the state is never left
+        return end;
+    }
+
+    const unsigned char byte1 = accel.bytes[0];
+    const unsigned char byte2 = accel.bytes[accel.size > 1 ? 1 : 0];
+    const unsigned char byte3 = accel.bytes[accel.size - 1];
+
+    auto isLeaving = [&](unsigned char c) {
+        return c == byte1 || c == byte2 || c == byte3;
+    };
+
+    // frequent bytes are usually found at once, so a few bytes are checked
+    // before a long search
+    constexpr ptrdiff_t shortSearch = 8;
+    for(const char* last = pos + std::min(end - pos, shortSearch); pos < last; ++pos) {
+        if(isLeaving(*pos)) {
+            return pos;
+        }
+    }
+
+    if(accel.size == 1) {
+        auto found = static_cast<const char*>(std::memchr(pos, byte1, end - pos));
+        return found ? found : end;
+    }
+
+#if FWC_X86_SIMD
+    constexpr ptrdiff_t width = sizeof(__m128i);
+
+    const __m128i vbyte1 = _mm_set1_epi8(byte1);
+    const __m128i vbyte2 = _mm_set1_epi8(byte2);
+    const __m128i vbyte3 = _mm_set1_epi8(byte3);
+
+    for(; end - pos >= width; pos += width) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        auto eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, vbyte1),
+                                            _mm_cmpeq_epi8(block, vbyte2)),
+                                            _mm_cmpeq_epi8(block, vbyte3));
+        if(unsigned mask = _mm_movemask_epi8(eq)) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#endif
+
+    while(pos < end && !isLeaving(*pos)) {
+        ++pos;
+    }
+
+    return pos;
+}
+
+std::uint32_t LazyDFA::findOrAddState(StateSet&& set) const {
+
+    std::string key(reinterpret_cast<const char*>(set.data()),
+                            set.size() * sizeof(std::uint32_t));
+    if(auto it = _index.find(key); it != _index.end()) {
+        return it->second;
+    }
+
+    if(_numOfStates == _maxStates) {
+        return 0;
+    }
+
+    const size_t idx = _numOfStates++;
+    std::uint32_t transition = idx * _numClasses;
+    if(set.empty()) {
+        // nothing can be matched
+        transition |= STOP_FLAG;
+    }
+    else if(acceptsAll(set, _scratch)) {
+        transition |= STOP_FLAG | ACCEPT_FLAG;
+    }
+    else if(findAccel(set, _scratch, _accels[idx])) {
+        transition |= ACCEL_FLAG;
+    }
+
+    _accepting[idx] = isAccepting(set);
+    _sets[idx] = std::move(set);
+    _index.emplace(std::move(key), transition);
+
+    return transition;
+}
+
+std::uint32_t LazyDFA::addTransition(std::uint32_t offset, std::uint16_t cls) const {
+
+    std::lock_guard lock(_mutex);
+
+    auto& entry = _table[offset + cls];
+    if(auto transition = entry.load(std::memory_order_relaxed)) {
+        // another thread made it
+        return transition;
+    }
+
+    auto next = step(_sets[offset / _numClasses], _representatives[cls], _scratch);
+    auto transition = findOrAddState(std::move(next));
+    if(transition) {
+        // the state is ready before the transition is seen by other threads
+        entry.store(transition, std::memory_order_release);
+    }
+
+    return transition;
+}
+
+bool LazyDFA::matchNFA(std::uint32_t offset, const char* pos, const char* end) const {
+
+    // sets of existing states don't change, so it can be read without the lock
+    StateSet current = _sets[offset / _numClasses];
+
+    Scratch scratch;
+    scratch.marks.assign(_nfa.states().size(), 0);
+    for(; pos < end && !current.empty(); ++pos) {
+        current = step(current, *pos, scratch);
+    }
+
+    return isAccepting(current);
+}
+
+} // namespace fwc
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <bitset>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+#include "noncopyable.h"
+
+namespace fwc {
+
+// Thompson NFA over bytes. It is made by compilers of patterns and
+// executed by LazyDFA. States are added from the end of a pattern to its
+// beginning, so the next state is usually known when a state is added.
+class NFA final
+{
+public:
+
+    using ByteSet = std::bitset<256>;
+
+    constexpr static std::uint32_t NONE = UINT32_MAX;
+
+    enum class Kind: std::uint8_t {
+        BYTES, // goes to 'next1' by a byte from the set
+        SPLIT, // goes to 'next1' and 'next2' without a byte
+        MATCH  // the whole text is matched if it ends here
+    };
+
+    struct State final {
+        Kind          kind;
+        std::uint32_t next1 { NONE };
+        std::uint32_t next2 { NONE };
+        ByteSet       bytes;
+    };
+
+    std::uint32_t addBytes(const ByteSet& bytes, std::uint32_t next) {
+        _states.push_back({ Kind::BYTES, next, NONE, bytes });
+        return _states.size() - 1;
+    }
+
+    std::uint32_t addSplit(std::uint32_t next1, std::uint32_t next2) {
+        _states.push_back({ Kind::SPLIT, next1, next2, {} });
+        return _states.size() - 1;
+    }
+
+    std::uint32_t addMatch() {
+        _states.push_back({ Kind::MATCH, NONE, NONE, {} });
+        return _states.size() - 1;
+    }
+
+    // it's used to make loops
+    void setNext1(std::uint32_t state, std::uint32_t next) { _states[state].next1 = next; }
+
+    void setStart(std::uint32_t state) noexcept { _start = state; }
+
+    [[nodiscard]]
+    std::uint32_t start() const noexcept { return _start; }
+
+    [[nodiscard]]
+    const std::vector<State>& states() const noexcept { return _states; }
+
+private:
+    std::vector<State> _states;
+    std::uint32_t      _start { NONE };
+};
+
+/*
+Deterministic automaton which is built from NFA lazily: a DFA state (a set
+of NFA states) and a transition are made only when a text goes there. So
+matching is one table lookup per byte without any backtracking, and only
+the states which the texts really need are built.
+Bytes which all NFA states treat in the same way share one class, the table
+of transitions has a column per class.
+The number of states is limited (patterns like '*a??????????' need 2^N
+states). When the limit is reached new transitions are not cached any more
+and the rest of such a text is matched by simulation of the NFA.
+States where the result is already known (nothing or anything can be
+matched further) stop matching at once. States which stay the same for all
+bytes but up to 3 ones (like the beginning of '*failed*') are accelerated:
+bytes are skipped with memchr or SSE2 until one of these bytes.
+It is thread safe: transitions are atomic and read without locks, new ones
+are made under a mutex. Memory of the table is allocated for all states in
+advance, so it never moves.
+*/
+
+class LazyDFA final: private noncopyable
+{
+public:
+
+    constexpr static size_t DEFAULT_MAX_STATES = 1024;
+
+    explicit LazyDFA(NFA&& nfa, size_t maxStates = DEFAULT_MAX_STATES);
+
+    [[nodiscard]]
+    bool isMatch(std::string_view text) const;
+
+    // number of built states, it's for statistics
+    [[nodiscard]]
+    size_t numOfStates() const;
+
+private:
+
+    // a transition is the offset of the next state in the table (the state
+    // index multiplied by the number of classes) with flags, 0 is unknown
+    // transition (the state 0 is not used). Transitions without flags are
+    // less than ACCEPT_FLAG, so one comparison is enough for them.
+    constexpr static std::uint32_t ACCEL_FLAG  = 1u << 31; // bytes can be skipped
+    constexpr static std::uint32_t STOP_FLAG   = 1u << 30; // the result is known
+    constexpr static std::uint32_t ACCEPT_FLAG = 1u << 29; // the result for STOP_FLAG
+    constexpr static std::uint32_t OFFSET_MASK = ACCEPT_FLAG - 1;
+
+    // bytes which leave an accelerated state
+    struct Accel final {
+        std::uint8_t  size { 0 };
+        unsigned char bytes[3] {};
+    };
+
+    using StateSet = std::vector<std::uint32_t>; // sorted NFA states
+
+    // temporary data for building of state sets
+    struct Scratch final {
+        std::vector<std::uint32_t> stack;
+        std::vector<std::uint32_t> marks;
+        std::uint32_t              mark { 0 };
+    };
+
+    void computeClasses();
+
+    void addClosure(std::uint32_t state, Scratch& scratch, StateSet& set) const;
+    StateSet step(const StateSet& from, unsigned char byte, Scratch& scratch) const;
+    bool isAccepting(const StateSet& set) const;
+
+    // the set is accepting and any byte leads to its superset,
+    // so any text is matched from here
+    bool acceptsAll(const StateSet& set, Scratch& scratch) const;
+
+    // find bytes which leave the state, returns false if there are many
+    bool findAccel(const StateSet& set, Scratch& scratch, Accel& accel) const;
+
+    // the first byte in [pos, end) which leaves the accelerated state
+    const char* skip(std::uint32_t offset, const char* pos, const char* end) const;
+
+    // Returns the transition to the state, it's 0 if there is no room for it
+    // The mutex must be locked
+    std::uint32_t findOrAddState(StateSet&& set) const;
+
+    std::uint32_t addTransition(std::uint32_t offset, std::uint16_t cls) const;
+    bool matchNFA(std::uint32_t offset, const char* pos, const char* end) const;
+
+    const NFA                          _nfa;
+    std::vector<std::uint16_t>         _classes;          // byte -> class
+    std::vector<unsigned char>         _representatives;  // class -> byte
+    size_t                             _numClasses { 0 };
+    size_t                             _maxStates  { 0 };
+    std::unique_ptr<std::atomic<std::uint32_t>[]> _table;
+    std::unique_ptr<bool[]>            _accepting;        // for each state
+    std::unique_ptr<Accel[]>           _accels;           // for each state
+    std::uint32_t                      _start { 0 };
+
+    std::unique_ptr<StateSet[]>        _sets;             // for each state
+
+    // states are added while texts are matched, under the mutex
+    mutable size_t                     _numOfStates { 0 };
+    mutable std::unordered_map<std::string, std::uint32_t> _index; // set -> transition
+    mutable Scratch                    _scratch;
+    mutable std::mutex                 _mutex;
+};
+
+/// Inline implementation
+
+inline bool LazyDFA::isMatch(std::string_view text) const {
+
+    const auto* table   = _table.get();
+    const auto* classes = _classes.data();
+
+    const char* pos = text.data();
+    const char* end = pos + text.size();
+
+    if(_start & STOP_FLAG) {
+        return _start & ACCEPT_FLAG;
+    }
+
+    std::uint32_t offset = _start & OFFSET_MASK;
+    if(_start & ACCEL_FLAG) {
+        pos = skip(offset, pos, end);
+    }
+
+    while(pos < end) {
+        const auto cls = classes[static_cast<unsigned char>(*pos)];
+        auto next = table[offset + cls].load(std::memory_order_acquire);
+        if(next - 1 >= ACCEPT_FLAG - 1) [[unlikely]] {
+            // unknown transition or a transition with flags
+            if(!next) {
+                next = addTransition(offset, cls);
+                if(!next) {
+                    // there is no room for new states
+                    return matchNFA(offset, pos, end);
+                }
+            }
+            if(next & STOP_FLAG) {
+                return next & ACCEPT_FLAG;
+            }
+            if(next & ACCEL_FLAG) {
+                offset = next & OFFSET_MASK;
+                pos = skip(offset, pos + 1, end);
+                continue;
+            }
+        }
+        offset = next;
+        ++pos;
+    }
+
+    return _accepting[offset / _numClasses];
+}
+
+} // namespace fwc
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <cassert>
 #include <cstring>
+#include <new>
+#include <limits>
+#include <algorithm>
 #include <stdexcept>
 #include <string_view>
 #include <vector>
@@ -12,7 +16,34 @@
 
 namespace fwc {
 
-// Simple buffer for data blocks
+// Allocator of memory aligned to pages,
+// it lets buffers to be used for reading with O_DIRECT
+template<typename T>
+struct PageAlignedAllocator {
+    using value_type = T;
+
+    constexpr static std::align_val_t ALIGNMENT { 4096 };
+
+    PageAlignedAllocator() noexcept = default;
+
+    template<typename U>
+    PageAlignedAllocator(const PageAlignedAllocator<U>&) noexcept {}
+
+    [[nodiscard]]
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), ALIGNMENT));
+    }
+
+    void deallocate(T* p, size_t) noexcept {
+        ::operator delete(p, ALIGNMENT);
+    }
+
+    template<typename U>
+    bool operator==(const PageAlignedAllocator<U>&) const noexcept { return true; }
+};
+
+// Simple buffer for data blocks,
+// memory is aligned to pages
 class BlocksBuffer final {
 public:
     using Pointer      = char*;
@@ -86,8 +117,8 @@ class BlocksBuffer final {
     }
 
 private:
-    std::vector<char> _buffer;
-    size_t            _blockSize { 0 };
+    std::vector<char, PageAlignedAllocator<char>> _buffer;
+    size_t _blockSize { 0 };
 };
 
 static_assert(std::is_move_constructible_v<BlocksBuffer>);
@@ -95,22 +126,154 @@ static_assert(std::is_move_assignable_v<BlocksBuffer>);
 static_assert( ! std::is_copy_constructible_v<BlocksBuffer>);
 static_assert( ! std::is_copy_assignable_v<BlocksBuffer>);
 
+// Limits of a lines block. A block ends when it has maxLines lines or when
+// its lines cover maxBytes of file. The last line can cross the byte budget,
+// so a block always has one line at least. With a byte budget the size of
+// blocks stays the same whatever the length of lines is.
+struct BlockLimits final {
+
+    constexpr static size_t NO_BYTES_LIMIT = std::numeric_limits<size_t>::max();
+
+    // lines are expected to be not shorter than it on average,
+    // it's used to get the max number of lines from a byte budget
+    constexpr static size_t MIN_AVG_LINE_SIZE = 8;
+
+    // it's implicit, so a number of lines can be given as limits
+    constexpr BlockLimits(size_t lines, size_t bytes = NO_BYTES_LIMIT) noexcept:
+        maxLines(lines), maxBytes(bytes) {}
+
+    // limits with a byte budget only, the number of lines adapts to it
+    [[nodiscard]]
+    constexpr static BlockLimits ofBytes(size_t bytes) noexcept {
+        return { std::max<size_t>(bytes / MIN_AVG_LINE_SIZE, 1), bytes };
+    }
+
+    size_t maxLines;
+    size_t maxBytes;
+};
+
 using FileLineRef  = std::string_view;
 using FileLineRefs = std::vector<FileLineRef>;
+using FileOffsets  = std::vector<std::uint64_t>;
+
+// Storage for lines which are longer than a slot of a lines buffer, a line is
+// built by parts and stays one line. Memory is allocated by chunks which are
+// kept after clear(), so there is no allocation while long lines fit the
+// chunks of previous blocks. Stored lines are valid till clear().
+class OverflowArena final {
+public:
+
+    constexpr static size_t DEFAULT_CHUNK_SIZE = 64*1024;
+
+    OverflowArena() noexcept = default;
+
+    OverflowArena(OverflowArena&&) noexcept = default;
+    OverflowArena& operator=(OverflowArena&&) noexcept = default;
+
+    void swap(OverflowArena& other) noexcept {
+        _chunks.swap(other._chunks);
+        std::swap(_chunk, other._chunk);
+        std::swap(_used, other._used);
+        std::swap(_lineBegin, other._lineBegin);
+    }
+
+    // allocate the first chunk
+    void reserve(size_t chunkSize = DEFAULT_CHUNK_SIZE) {
+        if(_chunks.empty()) {
+            _chunks.emplace_back(chunkSize);
+        }
+    }
+
+    // begin a new line
+    void startLine() noexcept { _lineBegin = _used; }
+
+    // append data to the current line
+    void append(const char* data, size_t size) {
+        if(_chunks.empty() || _used + size > _chunks[_chunk].size()) {
+            nextChunk(size);
+        }
+        std::memcpy(_chunks[_chunk].data() + _used, data, size);
+        _used += size;
+    }
+
+    // the current line
+    [[nodiscard]]
+    FileLineRef line() const noexcept {
+        if(_chunks.empty()) {
+            return { "", 0 };
+        }
+        return { _chunks[_chunk].data() + _lineBegin, _used - _lineBegin };
+    }
+
+    // drop all lines, memory is kept
+    void clear() noexcept {
+        _chunk = 0;
+        _used = _lineBegin = 0;
+    }
+
+    // check if a pointer belongs to the used part of the arena
+    [[nodiscard]]
+    bool owns(const char* p) const noexcept {
+        for(size_t i = 0; i < _chunks.size() && i <= _chunk; ++i) {
+            auto* begin = _chunks[i].data();
+            if(p >= begin && p < begin + (i == _chunk ? _used : _chunks[i].size())) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+
+    // move the current line into the next chunk which has room for it and
+    // for 'size' bytes more, lines in previous chunks stay where they are
+    void nextChunk(size_t size) {
+        const size_t lineSize = _used - _lineBegin;
+        const size_t needed = lineSize + size;
+
+        size_t next = _chunks.empty() ? 0 : _chunk + 1;
+        if(next == _chunks.size() || _chunks[next].size() < needed) {
+            // chunks are vectors, so their memory doesn't move here
+            _chunks.emplace(_chunks.begin() + next,
+                                std::max(DEFAULT_CHUNK_SIZE, 2 * needed));
+        }
+
+        if(lineSize) {
+            std::memcpy(_chunks[next].data(), _chunks[_chunk].data() + _lineBegin, lineSize);
+        }
+        _chunk = next;
+        _lineBegin = 0;
+        _used = lineSize;
+    }
+
+    std::vector<std::vector<char>> _chunks;
+    size_t _chunk     { 0 };
+    size_t _used      { 0 }; // in the current chunk
+    size_t _lineBegin { 0 }; // in the current chunk
+};
+
+static_assert(std::is_move_constructible_v<OverflowArena>);
+static_assert( ! std::is_copy_constructible_v<OverflowArena>);
 
 // Simplified class for effective storage of blocks of file lines
+// Lines are packed one after another in the buffer, a block of the buffer
+// is the max size of a line. Longer lines are kept in the overflow arena.
 class LinesBlock final {
 public:
 
     LinesBlock() noexcept = default;
 
-    LinesBlock(size_t maxLines, bool withBuffer,
+    LinesBlock(BlockLimits limits, bool withBuffer,
                     size_t bufferBlockSize = BlocksBuffer::DEFAULT_BLOCK_SIZE) {
-        alloc(maxLines, withBuffer, bufferBlockSize);
+        alloc(limits, withBuffer, bufferBlockSize);
     }
 
     LinesBlock& operator=(const LinesBlock& other) {
 
+        _offsets = other._offsets;
+        _firstLineNo = other._firstLineNo;
+        _seqNo = other._seqNo;
+
         if(other._buffer.empty()) {
             _lines = other._lines;
             _buffer.clear();
@@ -132,15 +295,31 @@ class LinesBlock final {
         }
 
         _lines.clear();
-        for(size_t i = 0; i < other._lines.size(); ++i) {
-            auto& othrline = other._lines[i];
-            auto* buff     = _buffer.get(i);
-
-            assert(othrline.cbegin() >= other._buffer.get(i));
-            assert(othrline.cend() < other._buffer.get(i) + other._buffer.blockSize());
+        _overflow.clear();
+
+        // lines in the buffer are packed, so they are copied at once
+        auto* otherBase = other._buffer.get(0);
+        auto* base      = _buffer.get(0);
+        size_t usedSize = 0;
+        for(auto it = other._lines.crbegin(); it != other._lines.crend(); ++it) {
+            if(other._buffer.owns(it->data())) {
+                usedSize = it->data() + it->size() - otherBase;
+                break;
+            }
+        }
+        assert(usedSize <= _buffer.size());
+        std::memcpy(base, otherBase, usedSize);
 
-            std::memcpy(buff, othrline.cbegin(), othrline.size());
-            _lines.emplace_back(buff, othrline.size());
+        for(auto& othrline: other._lines) {
+            if(other._buffer.owns(othrline.data())) {
+                _lines.emplace_back(base + (othrline.data() - otherBase), othrline.size());
+            }
+            else {
+                // long line
+                _overflow.startLine();
+                _overflow.append(othrline.data(), othrline.size());
+                _lines.push_back(_overflow.line());
+            }
         }
 
         return *this;
@@ -151,38 +330,68 @@ class LinesBlock final {
 
     void swap(LinesBlock& other) noexcept {
         _buffer.swap(other._buffer);
+        _overflow.swap(other._overflow);
         _lines.swap(other._lines);
+        _offsets.swap(other._offsets);
+        std::swap(_firstLineNo, other._firstLineNo);
+        std::swap(_seqNo, other._seqNo);
     }
 
-    void alloc(size_t maxLines, bool withBuffer,
+    void alloc(BlockLimits limits, bool withBuffer,
                     size_t bufferBlockSize = BlocksBuffer::DEFAULT_BLOCK_SIZE) {
-        _lines.reserve(maxLines);
+        _lines.reserve(limits.maxLines);
+        _offsets.reserve(limits.maxLines);
         if(withBuffer) {
-            _buffer.resize(maxLines, bufferBlockSize);
+            // the last line can begin right before the byte budget
+            auto numOfBlocks = std::min(limits.maxLines, limits.maxBytes / bufferBlockSize + 2);
+            _buffer.resize(numOfBlocks, bufferBlockSize);
+            _overflow.reserve();
         }
-        _maxLines = maxLines;
+        _limits = limits;
     }
 
-    void addLine(const FileLineRef& line) {
+    // add line with its byte offset in file
+    void addLine(const FileLineRef& line, std::uint64_t offset) {
         assert(checkLine(line));
         _lines.push_back(line);
-    }
-
-    void addLine(FileLineRef&& line) {
-        assert(checkLine(line));
-        _lines.push_back(std::move(line));
+        _offsets.push_back(offset);
     }
 
     // clear lines, it does not deallocate memory
     void clear() noexcept {
         _lines.clear();
+        _offsets.clear();
+        _overflow.clear();
     }
 
     [[nodiscard]]
     const FileLineRefs& lines() const noexcept { return _lines; }
 
     [[nodiscard]]
-    size_t maxLines() const noexcept { return _maxLines; };
+    bool empty() const noexcept { return _lines.empty(); }
+
+    // byte offsets of lines in file
+    [[nodiscard]]
+    const FileOffsets& offsets() const noexcept { return _offsets; }
+
+    // zero-based number of the first line of the block in file
+    [[nodiscard]]
+    size_t firstLineNo() const noexcept { return _firstLineNo; }
+
+    void setFirstLineNo(size_t lineNo) noexcept { _firstLineNo = lineNo; }
+
+    // sequence number of the block in file, it's set by processors which
+    // need to know the order of blocks
+    [[nodiscard]]
+    size_t seqNo() const noexcept { return _seqNo; }
+
+    void setSeqNo(size_t seqNo) noexcept { _seqNo = seqNo; }
+
+    [[nodiscard]]
+    size_t maxLines() const noexcept { return _limits.maxLines; };
+
+    [[nodiscard]]
+    size_t maxBytes() const noexcept { return _limits.maxBytes; };
 
     [[nodiscard]]
     const BlocksBuffer& buffer() const noexcept { return _buffer; }
@@ -190,10 +399,18 @@ class LinesBlock final {
     [[nodiscard]]
     BlocksBuffer& buffer() noexcept { return _buffer; }
 
+    // storage for lines which are longer than a block of the buffer
+    [[nodiscard]]
+    OverflowArena& overflow() noexcept { return _overflow; }
+
 private:
-    BlocksBuffer _buffer;
-    FileLineRefs _lines;
-    size_t       _maxLines { 0 };
+    BlocksBuffer  _buffer;
+    OverflowArena _overflow;
+    FileLineRefs  _lines;
+    FileOffsets   _offsets;
+    size_t        _firstLineNo { 0 };
+    size_t        _seqNo { 0 };
+    BlockLimits   _limits { 0 };
 
     [[nodiscard]]
     bool checkLine(const FileLineRef& line) const noexcept {
@@ -203,7 +420,8 @@ class LinesBlock final {
 
         auto* begin = line.data();
         auto* last = begin + line.size() - 1;
-        return _buffer.owns(begin) && _buffer.owns(last);
+        return (_buffer.owns(begin) && _buffer.owns(last)) ||
+                (_overflow.owns(begin) && _overflow.owns(last));
     }
 };
 
@@ -214,21 +432,146 @@ static_assert(std::is_copy_assignable_v<LinesBlock>);
 
 using LinesBlockPtr = LinesBlock*;
 
+// Compact layout of a lines block for lines which lie one after another in
+// memory (mmap of a file): a base pointer and 4 bytes per line instead of
+// FileLineRef and offset (24 bytes), so blocks which are passed between
+// threads take less cache lines. Each entry keeps the end of the line from
+// the base (30 bits) and the number of bytes between the end of the previous
+// line and the beginning of this one (2 bits, it's newline symbols).
+// So lines of a block must take less than 1 GB.
+class CompactLinesBlock final {
+public:
+
+    constexpr static size_t MAX_SIZE = (size_t(1) << 30) - 1;
+    constexpr static size_t MAX_GAP  = 3;
+
+    CompactLinesBlock() noexcept = default;
+
+    explicit CompactLinesBlock(BlockLimits limits, bool withBuffer = false) {
+        alloc(limits, withBuffer);
+    }
+
+    void swap(CompactLinesBlock& other) noexcept {
+        _ends.swap(other._ends);
+        std::swap(_base, other._base);
+        std::swap(_baseOffset, other._baseOffset);
+        std::swap(_firstLineNo, other._firstLineNo);
+        std::swap(_seqNo, other._seqNo);
+        std::swap(_limits, other._limits);
+    }
+
+    void alloc(BlockLimits limits, bool withBuffer = false) {
+        if(withBuffer) {
+            throw std::logic_error(
+                "CompactLinesBlock does not support file readers with line buffers");
+        }
+        _ends.reserve(limits.maxLines);
+        _limits = limits;
+    }
+
+    // check if the line can be added: it must follow the previous line
+    [[nodiscard]]
+    bool canAdd(const FileLineRef& line) const noexcept {
+        if(_ends.empty()) {
+            return line.size() <= MAX_SIZE;
+        }
+
+        const char* prevEnd = _base + (_ends.back() & END_MASK);
+        return line.data() >= prevEnd &&
+                static_cast<size_t>(line.data() - prevEnd) <= MAX_GAP &&
+                static_cast<size_t>(line.data() + line.size() - _base) <= MAX_SIZE;
+    }
+
+    // add line with its byte offset in file
+    void addLine(const FileLineRef& line, std::uint64_t offset) {
+        assert(canAdd(line));
+
+        std::uint32_t gap = 0;
+        if(_ends.empty()) {
+            _base = line.data();
+            _baseOffset = offset;
+        }
+        else {
+            gap = line.data() - (_base + (_ends.back() & END_MASK));
+        }
+
+        const std::uint32_t end = line.data() + line.size() - _base;
+        assert(offset == _baseOffset + end - line.size());
+        _ends.push_back(end | gap << GAP_SHIFT);
+    }
+
+    // clear lines, it does not deallocate memory
+    void clear() noexcept {
+        _ends.clear();
+        _base = nullptr;
+    }
+
+    [[nodiscard]]
+    size_t size() const noexcept { return _ends.size(); }
+
+    [[nodiscard]]
+    bool empty() const noexcept { return _ends.empty(); }
+
+    // call func(line, offset) for each line in order
+    template<typename Func>
+    void forEachLine(Func&& func) const {
+        std::uint32_t begin = 0;
+        for(auto entry: _ends) {
+            begin += entry >> GAP_SHIFT;
+            const std::uint32_t end = entry & END_MASK;
+            func(FileLineRef(_base + begin, end - begin), _baseOffset + begin);
+            begin = end;
+        }
+    }
+
+    // zero-based number of the first line of the block in file
+    [[nodiscard]]
+    size_t firstLineNo() const noexcept { return _firstLineNo; }
+
+    void setFirstLineNo(size_t lineNo) noexcept { _firstLineNo = lineNo; }
+
+    // sequence number of the block in file
+    [[nodiscard]]
+    size_t seqNo() const noexcept { return _seqNo; }
+
+    void setSeqNo(size_t seqNo) noexcept { _seqNo = seqNo; }
+
+    [[nodiscard]]
+    size_t maxLines() const noexcept { return _limits.maxLines; };
+
+    [[nodiscard]]
+    size_t maxBytes() const noexcept { return _limits.maxBytes; };
+
+private:
+    constexpr static unsigned      GAP_SHIFT = 30;
+    constexpr static std::uint32_t END_MASK  = MAX_SIZE;
+
+    std::vector<std::uint32_t> _ends;
+    const char*                _base        { nullptr };
+    std::uint64_t              _baseOffset  { 0 };
+    size_t                     _firstLineNo { 0 };
+    size_t                     _seqNo       { 0 };
+    BlockLimits                _limits      { 0 };
+};
+
+static_assert(std::is_move_constructible_v<CompactLinesBlock>);
+static_assert(std::is_copy_assignable_v<CompactLinesBlock>);
+
 // This is something that is similar to local allocator
 class LinesBlockPool final {
 public:
 
-    LinesBlockPool(size_t numOfBlocks, size_t maxLines,
+    LinesBlockPool(size_t numOfBlocks, BlockLimits limits,
                             size_t blockSize = BlocksBuffer::DEFAULT_BLOCK_SIZE):
-        _freeBlocks(numOfBlocks), _maxLines(maxLines), _blockSize(blockSize) {
+        _freeBlocks(numOfBlocks), _limits(limits), _blockSize(blockSize) {
 
         assert(numOfBlocks > 0);
-        assert(maxLines > 0);
+        assert(limits.maxLines > 0);
         assert(blockSize > 0);
 
         _blocks.reserve(numOfBlocks);
         for(size_t i = 0; i < numOfBlocks; ++i) {
-            _blocks.emplace_back(maxLines, false);
+            _blocks.emplace_back(limits, false);
         }
     }
 
@@ -239,7 +582,7 @@ class LinesBlockPool final {
         _freeBlocks.reset();
         for(auto& block: _blocks) {
             _freeBlocks.push(&block);
-            block.alloc(_maxLines, allocBuffers, _blockSize);
+            block.alloc(_limits, allocBuffers, _blockSize);
         }
     }
 
@@ -269,8 +612,8 @@ class LinesBlockPool final {
 
     VectorOfBlocks _blocks;
     BlockPtrsRing  _freeBlocks;
-    const size_t   _maxLines;
-    const size_t   _blockSize;
+    const BlockLimits _limits;
+    const size_t      _blockSize;
 };
 
 } // namespace fwc
\ No newline at end of file
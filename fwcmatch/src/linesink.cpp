@@ -0,0 +1,114 @@
+#include <cassert>
+#include <cstring>
+#include <cerrno>
+#include <charconv>
+#include <unistd.h>
+
+#include "utils.h"
+#include "linesink.h"
+
+namespace fwc {
+
+static char NEW_LINE[] = "\n";
+
+FdLineSink::FdLineSink(int fd, bool withLineNumbers, bool withOffsets):
+    _vecs(LINES_PER_WRITE * 3),
+    _prefixes(LINES_PER_WRITE * MAX_PREFIX_SIZE),
+    _fd(fd),
+    _withLineNumbers(withLineNumbers),
+    _withOffsets(withOffsets) {
+
+    assert(fd >= 0);
+}
+
+void FdLineSink::write(const MatchedLine* lines, size_t count) {
+
+    const bool withPrefix = _withLineNumbers || _withOffsets;
+
+    std::scoped_lock lock(_mutex);
+
+    size_t numOfVecs = 0;
+    char* prefix = _prefixes.data();
+
+    for(size_t i = 0; i < count; ++i) {
+
+        auto const& mline = lines[i];
+
+        if(withPrefix) {
+            char* end = prefix;
+            if(_withLineNumbers) {
+                end = std::to_chars(end, end + 20, mline.lineNo).ptr;
+                *end++ = ':';
+            }
+            if(_withOffsets) {
+                end = std::to_chars(end, end + 20, mline.offset).ptr;
+                *end++ = ':';
+            }
+            _vecs[numOfVecs++] = { prefix, size_t(end - prefix) };
+            prefix = end;
+        }
+
+        _vecs[numOfVecs++] = { const_cast<char*>(mline.line.data()), mline.line.size() };
+        _vecs[numOfVecs++] = { NEW_LINE, 1 };
+
+        if((i + 1) % LINES_PER_WRITE == 0) {
+            flush(numOfVecs);
+            numOfVecs = 0;
+            prefix = _prefixes.data();
+        }
+    }
+
+    flush(numOfVecs);
+}
+
+void FdLineSink::flush(size_t numOfVecs) {
+
+    auto* vec = _vecs.data();
+    while(numOfVecs > 0) {
+
+        auto written = ::writev(_fd, vec, int(numOfVecs));
+        if(written < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            errorAndStop("Writing of lines failed");
+        }
+
+        // skip what has been written, the last vector can be written partially
+        size_t bytes = size_t(written);
+        while(numOfVecs > 0 && bytes >= vec->iov_len) {
+            bytes -= vec->iov_len;
+            ++vec;
+            --numOfVecs;
+        }
+
+        if(numOfVecs > 0) {
+            vec->iov_base = static_cast<char*>(vec->iov_base) + bytes;
+            vec->iov_len -= bytes;
+        }
+    }
+}
+
+BufferLineSink::BufferLineSink(size_t capacity):
+    _buffer(capacity) {
+}
+
+void BufferLineSink::write(const MatchedLine* lines, size_t count) {
+
+    std::scoped_lock lock(_mutex);
+
+    for(size_t i = 0; i < count; ++i) {
+
+        auto const& line = lines[i].line;
+        if(_buffer.size() - _size < line.size() + 1) {
+            _overflowed = true;
+            return;
+        }
+
+        std::memcpy(_buffer.data() + _size, line.data(), line.size());
+        _size += line.size();
+        _buffer[_size++] = '\n';
+    }
+}
+
+} // namespace fwc
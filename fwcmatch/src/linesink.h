@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <sys/uio.h>
+
+#include "noncopyable.h"
+#include "linesblock.h"
+
+namespace fwc {
+
+// Line found by a processor. The line data is valid only while the sink
+// handles it, so a sink must copy the data if it wants to keep it.
+struct MatchedLine
+{
+    FileLineRef   line;
+    size_t        lineNo;  // one-based number of the line in file
+    std::uint64_t offset;  // byte offset of the line in file
+};
+
+using MatchedLines = std::vector<MatchedLine>;
+
+// Destination for matched lines.
+// The 'write' method can be called from different threads simultaneously,
+// each call gets lines from one block in the order of the file, but calls
+// from different threads are not ordered.
+class LineSink: private noncopyable
+{
+public:
+    virtual ~LineSink() {};
+
+    virtual void write(const MatchedLine* lines, size_t count) = 0;
+
+    void write(const MatchedLines& lines) {
+        write(lines.data(), lines.size());
+    }
+};
+
+// Writes lines into a file descriptor like grep does it, with optional
+// line numbers and byte offsets. All lines of one call are written with as
+// few writev calls as possible, memory is allocated once in the constructor.
+class FdLineSink final: public LineSink
+{
+public:
+    FdLineSink(int fd, bool withLineNumbers = false, bool withOffsets = false);
+
+    void write(const MatchedLine* lines, size_t count) override;
+
+private:
+
+    void flush(size_t numOfVecs);
+
+    // max length of "lineNo:offset:"
+    static constexpr size_t MAX_PREFIX_SIZE = 2*20 + 2;
+    static constexpr size_t LINES_PER_WRITE = 256;
+
+    std::mutex                _mutex;
+    std::vector<struct iovec> _vecs;
+    std::vector<char>         _prefixes;
+    const int                 _fd;
+    const bool                _withLineNumbers;
+    const bool                _withOffsets;
+};
+
+// Calls a function for each portion of lines, calls are serialized.
+class CallbackLineSink final: public LineSink
+{
+public:
+    using Callback = std::function<void(const MatchedLine* lines, size_t count)>;
+
+    explicit CallbackLineSink(Callback callback):
+        _callback(std::move(callback)) {
+    }
+
+    void write(const MatchedLine* lines, size_t count) override {
+        std::scoped_lock lock(_mutex);
+        _callback(lines, count);
+    }
+
+private:
+    std::mutex _mutex;
+    Callback   _callback;
+};
+
+// Copies lines into a buffer with a fixed capacity in bytes.
+// Lines which don't fit are dropped and the 'overflowed' flag is set.
+// Each line is stored with '\n' at the end.
+class BufferLineSink final: public LineSink
+{
+public:
+    explicit BufferLineSink(size_t capacity);
+
+    void write(const MatchedLine* lines, size_t count) override;
+
+    // it's not thread safe, call it when processing has finished
+    void clear() noexcept {
+        _size = 0;
+        _overflowed = false;
+    }
+
+    [[nodiscard]]
+    std::string_view data() const noexcept { return { _buffer.data(), _size }; }
+
+    [[nodiscard]]
+    bool overflowed() const noexcept { return _overflowed; }
+
+private:
+    std::mutex        _mutex;
+    std::vector<char> _buffer;
+    size_t            _size { 0 };
+    bool              _overflowed { false };
+};
+
+} // namespace fwc
@@ -0,0 +1,211 @@
+#include <cstdint>
+#include <cstring>
+#include <array>
+
+#include "cpufeatures.h"
+#include "literalsearch.h"
+
+#if FWC_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace fwc {
+
+using ByteRanks = std::array<std::uint8_t, 256>;
+
+// Heuristic frequencies of bytes in text logs: the bigger the rank is the
+// more often the byte can be met. Exact values are not important, it is only
+// needed to avoid selection of spaces and frequent letters as the bytes to search.
+static constexpr ByteRanks makeByteRanks() {
+
+    ByteRanks ranks {};
+    for(size_t i = 0; i < ranks.size(); ++i) {
+        ranks[i] = 10; // control symbols and non-ASCII bytes
+    }
+
+    // English letters from the most to the least frequent
+    constexpr const char* letters = "etaoinshrdlcumwfgypbvkjxqz";
+    for(size_t i = 0; letters[i]; ++i) {
+        ranks[static_cast<unsigned char>(letters[i])] = 240 - i * 4;
+        ranks[static_cast<unsigned char>(letters[i] - 'a' + 'A')] = 130 - i * 3;
+    }
+
+    for(unsigned char c = '0'; c <= '9'; ++c) {
+        ranks[c] = 170;
+    }
+
+    for(unsigned char c: std::string_view(".:,/-_=[]()'\"")) {
+        ranks[c] = 150;
+    }
+
+    ranks[static_cast<unsigned char>(' ')] = 255;
+    ranks[static_cast<unsigned char>('\t')] = 100;
+
+    return ranks;
+}
+
+static constexpr ByteRanks BYTE_RANKS = makeByteRanks();
+
+std::uint8_t byteRank(unsigned char c) noexcept {
+    return BYTE_RANKS[c];
+}
+
+LiteralSearcher::LiteralSearcher(std::string_view literal): _literal(literal) {
+
+    auto rank = [&](size_t idx) {
+        return BYTE_RANKS[static_cast<unsigned char>(_literal[idx])];
+    };
+
+    for(size_t i = 1; i < _literal.size(); ++i) {
+        if(rank(i) < rank(_rare1)) {
+            _rare1 = i;
+        }
+    }
+
+    _rare2 = _rare1 ? 0 : 1;
+    for(size_t i = 0; i < _literal.size(); ++i) {
+        if(i != _rare1 && rank(i) < rank(_rare2)) {
+            _rare2 = i;
+        }
+    }
+
+    if(_literal.size() < 2) {
+        // memchr is good enough in this case
+        _find = &findScalar;
+    }
+    else {
+#if FWC_X86_SIMD
+        _find = cpuHasAVX2() ? &findAVX2 : &findSSE2;
+#else
+        _find = &findScalar;
+#endif
+    }
+}
+
+const char* LiteralSearcher::findScalar(const LiteralSearcher& self,
+                                        const char* begin, const char* end) {
+
+    const char* literal = self._literal.data();
+    const size_t size   = self._literal.size();
+
+    if(static_cast<size_t>(end - begin) < size) {
+        return nullptr;
+    }
+
+    if(size < 2) {
+        return size ? static_cast<const char*>(
+                            std::memchr(begin, literal[0], end - begin)) : begin;
+    }
+
+    const size_t rare1 = self._rare1;
+    const size_t rare2 = self._rare2;
+
+    // search the rarest byte with memchr and check the rest on each hit
+    const char* last = end - size + rare1; // last possible position of the rare byte
+    for(const char* pos = begin + rare1; pos <= last; ++pos) {
+        pos = static_cast<const char*>(std::memchr(pos, literal[rare1], last + 1 - pos));
+        if(!pos) {
+            return nullptr;
+        }
+
+        const char* candidate = pos - rare1;
+        if(candidate[rare2] == literal[rare2] &&
+                        0 == std::memcmp(candidate, literal, size)) {
+            return candidate;
+        }
+    }
+
+    return nullptr;
+}
+
+#if FWC_X86_SIMD
+
+// check candidates from the bit mask
+static inline const char* checkCandidates(unsigned mask, const char* pos,
+                                        const char* literal, size_t size) {
+    while(mask) {
+        const char* candidate = pos + __builtin_ctz(mask);
+        if(0 == std::memcmp(candidate, literal, size)) {
+            return candidate;
+        }
+        mask &= mask - 1;
+    }
+    return nullptr;
+}
+
+const char* LiteralSearcher::findSSE2(const LiteralSearcher& self,
+                                        const char* begin, const char* end) {
+
+    constexpr ptrdiff_t width = sizeof(__m128i);
+
+    const char* literal = self._literal.data();
+    const size_t size   = self._literal.size();
+
+    const __m128i rare1 = _mm_set1_epi8(literal[self._rare1]);
+    const __m128i rare2 = _mm_set1_epi8(literal[self._rare2]);
+
+    // all loads must be inside [begin, end)
+    const char* pos = begin;
+    for(; end - pos >= static_cast<ptrdiff_t>(size) + width - 1; pos += width) {
+        auto block1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos + self._rare1));
+        auto block2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos + self._rare2));
+
+        auto eq = _mm_and_si128(_mm_cmpeq_epi8(block1, rare1), _mm_cmpeq_epi8(block2, rare2));
+        unsigned mask = _mm_movemask_epi8(eq);
+        if(mask) {
+            if(auto found = checkCandidates(mask, pos, literal, size)) {
+                return found;
+            }
+        }
+    }
+
+    return findScalar(self, pos, end);
+}
+
+__attribute__((target("avx2")))
+const char* LiteralSearcher::findAVX2(const LiteralSearcher& self,
+                                        const char* begin, const char* end) {
+
+    constexpr ptrdiff_t width = sizeof(__m256i);
+
+    const char* literal = self._literal.data();
+    const size_t size   = self._literal.size();
+
+    const __m256i rare1 = _mm256_set1_epi8(literal[self._rare1]);
+    const __m256i rare2 = _mm256_set1_epi8(literal[self._rare2]);
+
+    // all loads must be inside [begin, end)
+    const char* pos = begin;
+    for(; end - pos >= static_cast<ptrdiff_t>(size) + width - 1; pos += width) {
+        auto block1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos + self._rare1));
+        auto block2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos + self._rare2));
+
+        auto eq = _mm256_and_si256(_mm256_cmpeq_epi8(block1, rare1),
+                                        _mm256_cmpeq_epi8(block2, rare2));
+        unsigned mask = _mm256_movemask_epi8(eq);
+        if(mask) {
+            if(auto found = checkCandidates(mask, pos, literal, size)) {
+                return found;
+            }
+        }
+    }
+
+    // the rest is shorter than one AVX2 vector
+    return findSSE2(self, pos, end);
+}
+
+#else
+
+const char* LiteralSearcher::findSSE2(const LiteralSearcher& self,
+                                        const char* begin, const char* end) {
+    return findScalar(self, begin, end);
+}
+
+const char* LiteralSearcher::findAVX2(const LiteralSearcher& self,
+                                        const char* begin, const char* end) {
+    return findScalar(self, begin, end);
+}
+
+#endif
+
+} // namespace fwc
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace fwc {
+
+// Heuristic frequency of the byte in text logs, the bigger the more often
+[[nodiscard]]
+std::uint8_t byteRank(unsigned char c) noexcept;
+
+/*
+Fast search of a literal substring.
+It takes the pair of the rarest bytes of the literal (by some heuristic
+frequencies of bytes in text logs), looks for positions where both bytes
+are at their places with SSE2/AVX2 (selected at runtime) and compares
+the whole literal only on such candidates.
+It is immutable after creation and so it is thread safe.
+*/
+class LiteralSearcher final
+{
+public:
+
+    explicit LiteralSearcher(std::string_view literal);
+
+    // Find the leftmost occurrence of the literal in [begin, end)
+    // Returns nullptr if there is no occurrence
+    [[nodiscard]]
+    const char* find(const char* begin, const char* end) const noexcept {
+        return _find(*this, begin, end);
+    }
+
+    [[nodiscard]]
+    bool contains(std::string_view text) const noexcept {
+        return find(text.data(), text.data() + text.size()) != nullptr;
+    }
+
+    [[nodiscard]]
+    const std::string& literal() const noexcept { return _literal; }
+
+private:
+    using FindFunc = const char* (*)(const LiteralSearcher&, const char*, const char*);
+
+    static const char* findScalar(const LiteralSearcher& self,
+                                        const char* begin, const char* end);
+    static const char* findSSE2(const LiteralSearcher& self,
+                                        const char* begin, const char* end);
+    static const char* findAVX2(const LiteralSearcher& self,
+                                        const char* begin, const char* end);
+
+    std::string _literal;
+    size_t      _rare1 { 0 }; // offset of the rarest byte in the literal
+    size_t      _rare2 { 0 }; // offset of the second rarest byte in the literal
+    FindFunc    _find  { &findScalar };
+};
+
+} // namespace fwc
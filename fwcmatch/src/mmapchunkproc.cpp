@@ -0,0 +1,73 @@
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <optional>
+
+#include "literalsearch.h"
+#include "utils.h"
+#include "proctools.h"
+#include "mmapchunkproc.h"
+
+namespace fwc {
+
+MMapChunkedProcessor::MMapChunkedProcessor(size_t numOfThreads, ThreadPool* pool):
+    _counters(numOfThreads),
+    _bounds(numOfThreads + 1, 0),
+    _numOfThreads(numOfThreads),
+    _pool(pool) {
+
+    assert(_numOfThreads > 0);
+
+    // the calling thread is used as one of threads
+    if(!_pool) {
+        _ownPool = std::make_unique<ThreadPool>(_numOfThreads - 1);
+        _pool = _ownPool.get();
+    }
+    if(_pool->size() < _numOfThreads - 1) {
+        errorAndStop("Thread pool is too small for the processor", false);
+    }
+}
+
+size_t MMapChunkedProcessor::execute(MMapReader& freader, const std::string& filename,
+                                                    const CompiledPattern& cpattern) {
+
+    std::optional<LiteralSearcher> searcher;
+    if(auto literal = cpattern.requiredLiteral(); !literal.empty()) {
+        searcher.emplace(literal);
+    }
+
+    ScopedFileOpener fopener(freader, filename);
+
+    const auto data = freader.data();
+
+    // split the file into ranges, each range begins from a line start
+    _bounds.front() = 0;
+    _bounds.back() = data.size();
+    for(size_t i = 1; i < _numOfThreads; ++i) {
+        size_t pos = std::max(data.size() * i / _numOfThreads, _bounds[i - 1]);
+        if(pos > 0 && pos < data.size() && data[pos - 1] != '\n') {
+            auto eol = static_cast<const char*>(
+                    std::memchr(data.data() + pos, '\n', data.size() - pos));
+            pos = eol ? eol - data.data() + 1 : data.size();
+        }
+        _bounds[i] = pos;
+    }
+
+    auto threadFunc = [&](size_t idx) {
+        auto range = data.substr(_bounds[idx], _bounds[idx + 1] - _bounds[idx]);
+        _counters[idx].value = proctools::filterBuffer(cpattern,
+                                    searcher ? &*searcher : nullptr, range);
+    };
+
+    _pool->run(_numOfThreads - 1, threadFunc);
+    threadFunc(_numOfThreads - 1);
+    _pool->wait();
+
+    size_t result = 0;
+    for(auto const& counter: _counters) {
+        result += counter.value;
+    }
+    return result;
+}
+
+} // namespace fwc
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "noncopyable.h"
+#include "utils.h"
+#include "mmapreader.h"
+#include "wildcard.h"
+#include "threadpool.h"
+
+namespace fwc {
+
+/*
+This class implements the way without producer and queues at all. The whole
+file is already in memory with MMapReader so it is cut into byte ranges,
+one range for each thread. Each range is adjusted to begin from a line start
+and each thread filters its range independently.
+Lines around found literals are matched only (see SearchFirstProcessor).
+*/
+
+class MMapChunkedProcessor final: private noncopyable
+{
+public:
+
+    explicit MMapChunkedProcessor(size_t numOfThreads, ThreadPool* pool = nullptr);
+
+    size_t execute(MMapReader& freader, const std::string& filename,
+                    const CompiledPattern& cpattern);
+
+    size_t execute(MMapReader& freader, const std::string& filename,
+                    const WildcardMatch& wcmatch, const std::string& pattern) {
+        return execute(freader, filename, *wcmatch.compile(pattern));
+    }
+
+private:
+
+    // each counter is in its own cache line to avoid false sharing
+    struct alignas(CACHE_LINE_SIZE) Counter final {
+        size_t value { 0 };
+    };
+
+    std::vector<Counter>        _counters;
+    std::vector<size_t>         _bounds;
+    const size_t                _numOfThreads;
+    std::unique_ptr<ThreadPool> _ownPool;
+    ThreadPool*                 _pool;
+};
+
+} // namespace fwc
@@ -1,7 +1,10 @@
 
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <algorithm>
+#include <type_traits>
 #include <iostream>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -42,23 +45,61 @@ void MMapReader::open(const std::string& filename) {
     }
 
     _fileSize = sb.st_size;
+    resetPosition();
+
+    if(!_fileSize) {
+        // empty file can't be mapped, it's normal for a new log file in follow mode
+        return;
+    }
 
     _addr = ::mmap(NULL, _fileSize, PROT_READ, MAP_PRIVATE|MAP_POPULATE, _file, 0u);
     if(MAP_FAILED == _addr) {
         errorAndStop("mmap");
     }
 
-    _mapptr = static_cast<const char*>(_addr);
+    _mapbegin = _mapptr = static_cast<const char*>(_addr);
     _mapend = _mapptr + _fileSize;
 }
 
+bool MMapReader::refresh() {
+
+    assert(_file >= 0);
+
+    struct stat sb;
+    if (::fstat(_file, &sb) == -1) {
+        errorAndStop("fstat");
+    }
+
+    const size_t newSize = sb.st_size;
+    if(newSize <= _fileSize) {
+        // truncated file is handled by reopening
+        return true;
+    }
+
+    const size_t pos = _mapptr - _mapbegin;
+    void* addr = _addr ?
+        ::mremap(_addr, _fileSize, newSize, MREMAP_MAYMOVE) :
+        ::mmap(NULL, newSize, PROT_READ, MAP_PRIVATE, _file, 0u);
+    if(MAP_FAILED == addr) {
+        errorAndStop("mremap");
+    }
+
+    _addr = addr;
+    _fileSize = newSize;
+    _mapbegin = static_cast<const char*>(_addr);
+    _mapptr = _mapbegin + pos;
+    _mapend = _mapbegin + _fileSize;
+
+    return true;
+}
+
 // close file
 void MMapReader::close() {
 
     if(_addr) {
         ::munmap(_addr, _fileSize);
         _addr = nullptr;
-        _mapptr = _mapend = nullptr;
+        _mapbegin = _mapptr = _mapend = nullptr;
     }
 
     if(_file >= 0) {
@@ -67,12 +108,27 @@ void MMapReader::close() {
     }
 }
 
+bool MMapReader::seek(size_t offset) {
+
+    assert(_file >= 0);
+
+    offset = std::min(offset, _fileSize);
+    _mapptr = _mapbegin + offset;
+    if(offset > 0 && offset < _fileSize && *(_mapptr - 1) != '\n') {
+        // skip the rest of the line
+        auto eol = static_cast<const char*>(::memchr(_mapptr, '\n', _mapend - _mapptr));
+        _mapptr = eol ? eol + 1 : _mapend;
+    }
+
+    resetPosition(_mapptr - _mapbegin);
+    return true;
+}
+
 // read next line in file
 FileLineRef MMapReader::readLine() {
 
     // It is experimental code and so I don't do correct error handling for all cases
     assert(_file >= 0);
-    assert(_mapptr);
 
     if( _mapptr >= _mapend) {
         return {};
@@ -93,14 +149,124 @@ FileLineRef MMapReader::readLine() {
         }
         lineSize = eol - _mapptr;
     }
+    else if(followMode()) {
+        // wait for the rest of the line
+        return {};
+    }
     else {
         lineSize = _mapend - _mapptr;
     }
 
     FileLineRef result { _mapptr, lineSize };
     _mapptr += lineSize + eolOffset;
+    advancePosition(lineSize + eolOffset);
 
     return result;
 }
 
+bool MMapReader::readLines(LinesBlock& block, size_t maxLines, size_t endOffset) {
+    readLinesImpl(block, maxLines, endOffset);
+    return true;
+}
+
+bool MMapReader::readLines(CompactLinesBlock& block, size_t maxLines, size_t endOffset) {
+    readLinesImpl(block, maxLines, endOffset);
+    return true;
+}
+
+template<typename Block>
+void MMapReader::readLinesImpl(Block& block, size_t maxLines, size_t endOffset) {
+
+    assert(_file >= 0);
+
+    // a compact block ends earlier if it would be bigger than it can be
+    auto fits = [&block](const FileLineRef& line) {
+        if constexpr (std::is_same_v<Block, CompactLinesBlock>) {
+            if(!block.canAdd(line)) {
+                if(block.empty()) {
+                    errorAndStop("Line is too long for CompactLinesBlock", false);
+                }
+                return false;
+            }
+        }
+        return true;
+    };
+
+    if(_index.capacity() < maxLines) {
+        // it's done once for a processor
+        _index.reserve(maxLines);
+    }
+
+    const char* begin = _mapptr;
+    const size_t beginOffset = begin - _mapbegin;
+    if(beginOffset >= endOffset) {
+        return;
+    }
+
+    const char* scanEnd = _mapend;
+    if(static_cast<size_t>(_mapend - begin) > UINT32_MAX) {
+        scanEnd = begin + UINT32_MAX;
+    }
+
+    // lines must begin before the limit, so only the newline of the line
+    // which crosses it is needed after it
+    const char* limit = scanEnd;
+    if(endOffset - beginOffset < static_cast<size_t>(scanEnd - begin)) {
+        limit = begin + (endOffset - beginOffset);
+    }
+
+    const size_t count = _index.build(begin, limit, maxLines);
+
+    const char* lineBegin = begin;
+    size_t i = 0;
+    for(; i < count; ++i) {
+        // strip newline symbol
+        const char* eol = begin + _index[i];
+        FileLineRef line { lineBegin, static_cast<size_t>(eol - lineBegin) };
+        if(!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        if(!fits(line)) {
+            break;
+        }
+
+        block.addLine(line, lineBegin - _mapbegin);
+        lineBegin = eol + 1;
+    }
+
+    // the line which begins before the limit and ends after it
+    if(i == count && count < maxLines && lineBegin < limit) {
+        const char* eol = static_cast<const char*>(std::memchr(limit, '\n', scanEnd - limit));
+        const char* lineEnd = eol;
+        if(!eol && scanEnd == _mapend && !followMode()) {
+            // the last line without newline, in follow mode it waits for the rest
+            lineEnd = _mapend;
+        }
+        else if(!eol && scanEnd != _mapend && !count) {
+            // a line which is longer than 4 GB, it's not realistic for logs
+            const size_t offset = this->offset();
+            if(auto line = readLine(); line.data() && fits(line)) {
+                block.addLine(line, offset);
+            }
+            return;
+        }
+
+        if(lineEnd) {
+            FileLineRef line { lineBegin, static_cast<size_t>(lineEnd - lineBegin) };
+            if(eol && !line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if(fits(line)) {
+                block.addLine(line, lineBegin - _mapbegin);
+                lineBegin = eol ? eol + 1 : _mapend;
+                ++i;
+            }
+        }
+    }
+
+    _mapptr = lineBegin;
+    advancePosition(lineBegin - begin, i);
+}
+
 } // namespace fwc
\ No newline at end of file
@@ -2,8 +2,10 @@
 
 #include <cstddef>
 #include <cstdio>
+#include <string_view>
 
 #include "filereader.h"
+#include "newlineindex.h"
 
 namespace fwc {
 
@@ -25,12 +27,31 @@ class MMapReader final: public FileReader
     // FileLineRef is used to avoid copying
     FileLineRef readLine() override;
 
+    // lines are split by NewlineIndex
+    bool readLines(LinesBlock& block, size_t maxLines, size_t endOffset) override;
+    bool readLines(CompactLinesBlock& block, size_t maxLines, size_t endOffset) override;
+
+    bool seek(size_t offset) override;
+    bool canSeek() const override { return true; }
+
+    // remap file if it has grown
+    bool refresh() override;
+
+    // the whole content of the open file
+    [[nodiscard]]
+    std::string_view data() const noexcept { return { _mapbegin, _fileSize }; }
+
 private:
+    template<typename Block>
+    void readLinesImpl(Block& block, size_t maxLines, size_t endOffset);
+
     void*       _addr     { nullptr };
+    const char* _mapbegin { nullptr };
     const char* _mapptr   { nullptr };
     const char* _mapend   { nullptr };
     size_t      _fileSize { 0 };
     int         _file =   { -1};
+    NewlineIndex _index;
 };
 
 } // namespace fwc
\ No newline at end of file
@@ -1,5 +1,6 @@
 
 #include <cassert>
+#include <cstdint>
 
 #include "utils.h"
 #include "proctools.h"
@@ -8,20 +9,31 @@
 namespace fwc {
 
 MTCondVarProcessor::MTCondVarProcessor(size_t queueSize, size_t numOfConsThreads,
-                                        size_t maxLines, bool needsBuffer):
-    BaseProdConsProcessor(numOfConsThreads),
+                                        BlockLimits limits, bool needsBuffer,
+                                        ThreadPool* pool):
+    BaseProdConsProcessor(numOfConsThreads, pool),
     _blocksQueue(queueSize) {
 
     assert(queueSize > 0);
 
     _blocksQueue.apply([&](LinesBlock& block) {
-        block.alloc(maxLines, needsBuffer);
+        block.alloc(limits, needsBuffer);
     });
 
     auto numOfThreads = numOfConsThreads + 1;
     _firstBlocks.reserve(numOfThreads);
     for(size_t i = 0; i < numOfThreads; ++i) {
-        _firstBlocks.emplace_back(maxLines, needsBuffer);
+        _firstBlocks.emplace_back(limits, needsBuffer);
+    }
+}
+
+void MTCondVarProcessor::setAdaptive(bool adaptive) {
+
+    if(adaptive) {
+        _tuner = std::make_unique<Autotuner>(_counters.size(), _blocksQueue.capacity());
+    }
+    else {
+        _tuner.reset();
     }
 }
 
@@ -29,6 +41,9 @@ void MTCondVarProcessor::init() {
 
     _stop = false;
     _blocksQueue.reset();
+    if(_tuner) {
+        _tuner->reset(_firstBlocks[0].maxBytes());
+    }
 }
 
 /*
@@ -57,9 +72,28 @@ void MTCondVarProcessor::readFileLines(FileReader& freader) {
 
     auto& block = _firstBlocks[0];
 
+    auto readBlock = [&]() {
+        if(!_tuner) {
+            readInLinesBlock(freader, block);
+            return;
+        }
+
+        const size_t offset = freader.offset();
+        const size_t budget = _tuner->budget();
+        const size_t endOffset = budget < SIZE_MAX - offset ? offset + budget : SIZE_MAX;
+        if(_tuner->tuned()) {
+            readInLinesBlock(freader, block, endOffset);
+            return;
+        }
+
+        const auto start = Autotuner::Clock::now();
+        readInLinesBlock(freader, block, endOffset);
+        _tuner->blockRead(freader.offset() - offset, Autotuner::Clock::now() - start);
+    };
+
     for(;;) {
 
-        proctools::readInLinesBlock(freader, block);
+        readBlock();
         if(block.lines().empty()) {
             // end of file
             break;
@@ -79,8 +113,7 @@ void MTCondVarProcessor::readFileLines(FileReader& freader) {
     _cvNonEmpty.notify_all();
 }
 
-void MTCondVarProcessor::filterLines(size_t idx,
-                            WildcardMatch& wcmatch, const std::string& pattern) {
+void MTCondVarProcessor::filterLines(size_t idx, const CompiledPattern& cpattern) {
 
     assert(idx < _counters.size());
     size_t counter = 0;
@@ -88,10 +121,16 @@ void MTCondVarProcessor::filterLines(size_t idx,
 
     for(;;) {
 
+        if(_tuner && idx >= _tuner->activeConsumers()) {
+            // parked, the rest of blocks is taken by active consumers
+            break;
+        }
+
         std::unique_lock<std::mutex> lock(_queueMutex);
         if(_blocksQueue.empty()) {
             _cvNonEmpty.wait(lock, [&](){ return !_blocksQueue.empty() || _stop; });
-            if(_stop) {
+            if(_blocksQueue.empty()) {
+                // stopped and there are no blocks left in the queue
                 break;
             }
         }
@@ -106,7 +145,14 @@ void MTCondVarProcessor::filterLines(size_t idx,
         }
         lock.unlock();
 
-        counter += proctools::filterBlock(wcmatch, pattern, block);
+        if(_tuner && !_tuner->tuned()) {
+            const auto start = Autotuner::Clock::now();
+            counter += filterBlock(idx, cpattern, block);
+            _tuner->blockFiltered(idx, Autotuner::Clock::now() - start);
+            continue;
+        }
+
+        counter += filterBlock(idx, cpattern, block);
     }
 
     _counters[idx] = counter;
@@ -3,10 +3,12 @@
 #include <cstddef>
 #include <string>
 #include <vector>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
 
 #include "basepcproc.h"
+#include "autotuner.h"
 
 namespace fwc {
 
@@ -14,21 +16,30 @@ namespace fwc {
 This class implements strategy of solving the problem with mutexes and
 condition variables. There is no memory reallocation during processing and
 it uses ring buffer for the queue of data between producer and consumers.
+In adaptive mode the byte budget of blocks (up to the preallocated one) and
+the number of consumers are tuned during the first MBs of each file, parked
+consumers just finish their work because other consumers share the queue.
 */
 
 class MTCondVarProcessor final: public BaseProdConsProcessor
 {
 public:
     MTCondVarProcessor(size_t queueSize, size_t numOfConsThreads,
-                        size_t maxLines, bool needsBuffer);
+                        BlockLimits limits, bool needsBuffer,
+                        ThreadPool* pool = nullptr);
+
+    void setAdaptive(bool adaptive);
+
+    // it is null if adaptive mode is off
+    [[nodiscard]]
+    const Autotuner* autotuner() const noexcept { return _tuner.get(); }
 
 private:
 
     using BlocksRing = SimpleRingBuffer<LinesBlock>;
 
     void readFileLines(FileReader& freader) override;
-    void filterLines(size_t idx, WildcardMatch& wcmatch,
-                                        const std::string& pattern) override;
+    void filterLines(size_t idx, const CompiledPattern& cpattern) override;
 
     void init() override;
 
@@ -37,6 +48,7 @@ class MTCondVarProcessor final: public BaseProdConsProcessor
     std::mutex              _queueMutex;
     std::condition_variable _cvNonEmpty;
     std::condition_variable _cvNonFull;
+    std::unique_ptr<Autotuner> _tuner;
     bool                    _stop        { false };
 };
 
@@ -7,33 +7,38 @@
 
 namespace fwc {
 
-MTCondVarProcessor2::MTCondVarProcessor2(size_t queueSize, size_t numOfConsThreads,
-                                        size_t maxLines, bool needsBuffer):
-    BaseProdConsProcessor(numOfConsThreads),
+template<typename Block>
+BasicMTCondVarProcessor2<Block>::BasicMTCondVarProcessor2(size_t queueSize,
+                                        size_t numOfConsThreads,
+                                        BlockLimits limits, bool needsBuffer,
+                                        ThreadPool* pool):
+    BaseProdConsProcessor(numOfConsThreads, pool),
     _blocksQueue(queueSize, numOfConsThreads),
     _needsBuffer(needsBuffer) {
 
     assert(queueSize > 0);
 
-    _blocksQueue.apply([&](LinesBlock& block) {
-        block.alloc(maxLines, needsBuffer);
+    _blocksQueue.apply([&](Block& block) {
+        block.alloc(limits, needsBuffer);
     });
 
     auto numOfThreads = numOfConsThreads + 1;
     _localBlocks.reserve(numOfThreads);
     for(size_t i = 0; i < numOfThreads; ++i) {
         // these blocks are used only when needsBuffer == false
-        _localBlocks.emplace_back(maxLines, false);
+        _localBlocks.emplace_back(limits, false);
     }
 }
 
-void MTCondVarProcessor2::init() {
+template<typename Block>
+void BasicMTCondVarProcessor2<Block>::init() {
 
     _stop = false;
     _blocksQueue.reset();
 }
 
-void MTCondVarProcessor2::readFileLines(FileReader& freader) {
+template<typename Block>
+void BasicMTCondVarProcessor2<Block>::readFileLines(FileReader& freader) {
 
     auto waitIfFull = [&](auto& lock) {
         if(_blocksQueue.full()) {
@@ -42,7 +47,7 @@ void MTCondVarProcessor2::readFileLines(FileReader& freader) {
     };
 
     if(_needsBuffer) {
-        LinesBlockPtr block = nullptr;
+        Block* block = nullptr;
         for(;;) {
 
             std::unique_lock<std::mutex> lock(_queueMutex);
@@ -51,8 +56,8 @@ void MTCondVarProcessor2::readFileLines(FileReader& freader) {
             block = _blocksQueue.enqueuePrepare();
             lock.unlock();
 
-            proctools::readInLinesBlock(freader, *block);
-            if(block->lines().empty()) {
+            readInLinesBlock(freader, *block);
+            if(block->empty()) {
                 break;
             }
 
@@ -64,8 +69,8 @@ void MTCondVarProcessor2::readFileLines(FileReader& freader) {
     else {
         auto& block = _localBlocks[0];
         for(;;) {
-            proctools::readInLinesBlock(freader, block);
-            if(block.lines().empty()) {
+            readInLinesBlock(freader, block);
+            if(block.empty()) {
                 break;
             }
 
@@ -83,11 +88,11 @@ void MTCondVarProcessor2::readFileLines(FileReader& freader) {
     _cvNonEmpty.notify_all();
 }
 
-void MTCondVarProcessor2::filterLines(size_t idx,
-                            WildcardMatch& wcmatch, const std::string& pattern) {
+template<typename Block>
+void BasicMTCondVarProcessor2<Block>::filterLines(size_t idx, const CompiledPattern& cpattern) {
 
     size_t counter = 0;
-    LinesBlockPtr block = nullptr;
+    Block* block = nullptr;
     auto& blockCopy = _localBlocks[idx + 1];
 
     for(;;) {
@@ -95,7 +100,8 @@ void MTCondVarProcessor2::filterLines(size_t idx,
         std::unique_lock<std::mutex> lock(_queueMutex);
         if(_blocksQueue.empty()) {
             _cvNonEmpty.wait(lock, [&](){ return !_blocksQueue.empty() || _stop; });
-            if(_stop) {
+            if(_blocksQueue.empty()) {
+                // stopped and there are no blocks left in the queue
                 break;
             }
         }
@@ -104,7 +110,7 @@ void MTCondVarProcessor2::filterLines(size_t idx,
         if(_needsBuffer) {
             lock.unlock();
 
-            counter += proctools::filterBlock(wcmatch, pattern, *block);
+            counter += filterBlock(idx, cpattern, *block);
 
             lock.lock();
             _blocksQueue.dequeueCommit(idx);
@@ -121,11 +127,14 @@ void MTCondVarProcessor2::filterLines(size_t idx,
             }
             lock.unlock();
 
-            counter += proctools::filterBlock(wcmatch, pattern, blockCopy);
+            counter += filterBlock(idx, cpattern, blockCopy);
         }
     }
 
     _counters[idx] = counter;
 }
 
+template class BasicMTCondVarProcessor2<LinesBlock>;
+template class BasicMTCondVarProcessor2<CompactLinesBlock>;
+
 } // namespace fwc
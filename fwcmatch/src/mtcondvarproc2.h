@@ -16,26 +16,29 @@ namespace fwc {
 This class implements alternative version of MTCondVarProcessor.
 In theory this implemenation has better memory locality but uses more mutex locks
 or copying of blocks if blocks without a buffer (mmap).
+Block is LinesBlock or CompactLinesBlock (only for readers without a line
+buffer, copying of such blocks is much cheaper).
 */
 
-class MTCondVarProcessor2 final: public BaseProdConsProcessor
+template<typename Block>
+class BasicMTCondVarProcessor2 final: public BaseProdConsProcessor
 {
 public:
-    MTCondVarProcessor2(size_t queueSize, size_t numOfConsThreads,
-                        size_t maxLines, bool needsBuffer);
+    BasicMTCondVarProcessor2(size_t queueSize, size_t numOfConsThreads,
+                        BlockLimits limits, bool needsBuffer,
+                        ThreadPool* pool = nullptr);
 
 private:
 
-    using BlocksRing = DRingBuffer<LinesBlock>;
+    using BlocksRing = DRingBuffer<Block>;
 
     void readFileLines(FileReader& freader) override;
-    void filterLines(size_t idx, WildcardMatch& wcmatch,
-                                        const std::string& pattern) override;
+    void filterLines(size_t idx, const CompiledPattern& cpattern) override;
 
     void init() override;
 
     BlocksRing              _blocksQueue;
-    std::vector<LinesBlock> _localBlocks;
+    std::vector<Block>      _localBlocks;
     std::mutex              _queueMutex;
     std::condition_variable _cvNonEmpty;
     std::condition_variable _cvNonFull;
@@ -43,4 +46,7 @@ class MTCondVarProcessor2 final: public BaseProdConsProcessor
     const bool              _needsBuffer;
 };
 
+using MTCondVarProcessor2        = BasicMTCondVarProcessor2<LinesBlock>;
+using MTCondVarCompactProcessor2 = BasicMTCondVarProcessor2<CompactLinesBlock>;
+
 } // namespace fwc
\ No newline at end of file
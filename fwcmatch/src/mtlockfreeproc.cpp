@@ -7,23 +7,27 @@
 
 namespace fwc {
 
-MTLockFreeProcessor::MTLockFreeProcessor(size_t queueSize, size_t numOfConsThreads,
-                                        size_t maxLines, bool needsBuffer):
-    BaseProdConsProcessor(numOfConsThreads) {
+template<typename Block>
+BasicMTLockFreeProcessor<Block>::BasicMTLockFreeProcessor(size_t queueSize,
+                                        size_t numOfConsThreads,
+                                        BlockLimits limits, bool needsBuffer,
+                                        ThreadPool* pool):
+    BaseProdConsProcessor(numOfConsThreads, pool) {
 
     assert(queueSize > 0);
 
     _consThreadInfo.reserve(numOfConsThreads);
     for(size_t i = 0; i < numOfConsThreads; ++i) {
         auto cinfo = std::make_unique<ConsumerInfo>(queueSize);
-        cinfo->blocksQueue.apply([&](LinesBlock& block) {
-            block.alloc(maxLines, needsBuffer);
+        cinfo->blocksQueue.apply([&](Block& block) {
+            block.alloc(limits, needsBuffer);
         });
         _consThreadInfo.push_back(std::move(cinfo));
     }
 }
 
-void MTLockFreeProcessor::init() {
+template<typename Block>
+void BasicMTLockFreeProcessor<Block>::init() {
 
     _stop.store(false, std::memory_order_release);
 
@@ -32,7 +36,8 @@ void MTLockFreeProcessor::init() {
     }
 }
 
-void MTLockFreeProcessor::readFileLines(FileReader& freader) {
+template<typename Block>
+void BasicMTLockFreeProcessor<Block>::readFileLines(FileReader& freader) {
 
     const auto numOfConsThreads = _consThreadInfo.size();
     const size_t maxFailedPushes = numOfConsThreads * 1000;
@@ -41,9 +46,9 @@ void MTLockFreeProcessor::readFileLines(FileReader& freader) {
     size_t consumerIdx = 0;
 
     bool noData = false;
-    auto readBlock = [&](LinesBlock& block) {
-        proctools::readInLinesBlock(freader, block);
-        noData = block.lines().empty();
+    auto readBlock = [&](Block& block) {
+        readInLinesBlock(freader, block);
+        noData = block.empty();
     };
 
     for(;;) {
@@ -73,16 +78,16 @@ void MTLockFreeProcessor::readFileLines(FileReader& freader) {
     _stop.store(true, std::memory_order_release);
 }
 
-void MTLockFreeProcessor::filterLines(size_t idx,
-                            WildcardMatch& wcmatch, const std::string& pattern) {
+template<typename Block>
+void BasicMTLockFreeProcessor<Block>::filterLines(size_t idx, const CompiledPattern& cpattern) {
 
     constexpr size_t maxSpins = 1000;
     auto& consInfo = *_consThreadInfo[idx];
     size_t counter = 0;
     size_t spinner = 0;
 
-    auto handleBlock = [&](LinesBlock const& block) {
-        counter += proctools::filterBlock(wcmatch, pattern, block);
+    auto handleBlock = [&](Block const& block) {
+        counter += filterBlock(idx, cpattern, block);
     };
 
     for(;;) {
@@ -109,4 +114,7 @@ void MTLockFreeProcessor::filterLines(size_t idx,
     consInfo.counter = counter;
 }
 
+template class BasicMTLockFreeProcessor<LinesBlock>;
+template class BasicMTLockFreeProcessor<CompactLinesBlock>;
+
 } // namespace fwc
\ No newline at end of file
@@ -20,16 +20,20 @@ This is not the best and fastest solution of such type but it can show the main
 disadvantage of this method.
 
 There is no memory reallocation during processing.
+Block is LinesBlock or CompactLinesBlock (only for readers without a line
+buffer, it makes ring buffers much smaller).
 */
-class MTLockFreeProcessor final: public BaseProdConsProcessor
+template<typename Block>
+class BasicMTLockFreeProcessor final: public BaseProdConsProcessor
 {
 public:
-    MTLockFreeProcessor(size_t queueSize, size_t numOfConsThreads,
-                                    size_t maxLines, bool needsBuffer);
+    BasicMTLockFreeProcessor(size_t queueSize, size_t numOfConsThreads,
+                                    BlockLimits limits, bool needsBuffer,
+                                    ThreadPool* pool = nullptr);
 
 private:
 
-    using WFBlockRing = WFSimpleRingBuffer<LinesBlock>; // wait free ring buffer
+    using WFBlockRing = WFSimpleRingBuffer<Block>; // wait free ring buffer
 
     // specific info for each consumer's thread
     struct ConsumerInfo final {
@@ -49,8 +53,7 @@ class MTLockFreeProcessor final: public BaseProdConsProcessor
     using VectorOfConsumerInfo = std::vector<ConsumerInfoUPtr>;
 
     void readFileLines(FileReader& freader) override;
-    void filterLines(size_t idx, WildcardMatch& wcmatch,
-                                    const std::string& pattern) override;
+    void filterLines(size_t idx, const CompiledPattern& cpattern) override;
 
     size_t calcFinalResult() const override;
     void init() override;
@@ -59,7 +62,8 @@ class MTLockFreeProcessor final: public BaseProdConsProcessor
     std::atomic<bool>    _stop { false };
 };
 
-inline size_t MTLockFreeProcessor::calcFinalResult() const {
+template<typename Block>
+inline size_t BasicMTLockFreeProcessor<Block>::calcFinalResult() const {
     size_t result = 0;
     for(auto const& consInfo: _consThreadInfo) {
         result += consInfo->counter;
@@ -67,4 +71,7 @@ inline size_t MTLockFreeProcessor::calcFinalResult() const {
     return result;
 }
 
+using MTLockFreeProcessor        = BasicMTLockFreeProcessor<LinesBlock>;
+using MTLockFreeCompactProcessor = BasicMTLockFreeProcessor<CompactLinesBlock>;
+
 } // namespace fwc
\ No newline at end of file
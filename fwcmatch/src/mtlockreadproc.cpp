@@ -3,34 +3,54 @@
 #include <cstddef>
 #include <algorithm>
 #include <numeric>
-#include <thread>
 #include <omp.h>
 
+#include "utils.h"
 #include "proctools.h"
 #include "mtlockreadproc.h"
 
 // I don't know why but implementation with OpenMP can work a little bit faster
-#define USE_OPENMP_IMPL 1
+// but threads of OpenMP runtime cannot be shared with other processors
+// and the thread pool is used by default.
+#define USE_OPENMP_IMPL 0
 
 namespace fwc {
 
 static constexpr size_t BLOCK_SIZE = 2*1024;
 
-MTLockReadProcessor::MTLockReadProcessor(size_t numOfThreads, size_t maxLines, bool needsBuffer):
+MTLockReadProcessor::MTLockReadProcessor(size_t numOfThreads, BlockLimits limits,
+                                        bool needsBuffer, ThreadPool* pool):
     _counters(numOfThreads, 0),
-    _numOfThreads(numOfThreads) {
+    _numOfThreads(numOfThreads),
+    _pool(pool) {
 
-    assert(maxLines > 0);
+    assert(limits.maxLines > 0);
     assert(_numOfThreads > 0);
 
+    // the calling thread is used as one of threads
+    if(!_pool) {
+        _ownPool = std::make_unique<ThreadPool>(_numOfThreads - 1);
+        _pool = _ownPool.get();
+    }
+    if(_pool->size() < _numOfThreads - 1) {
+        errorAndStop("Thread pool is too small for the processor", false);
+    }
+
     _linesBlocks.reserve(_numOfThreads);
+    _matched.resize(_numOfThreads);
     for(size_t i = 0; i < _numOfThreads; ++i) {
-        _linesBlocks.emplace_back(maxLines, needsBuffer, BLOCK_SIZE);
+        _linesBlocks.emplace_back(limits, needsBuffer, BLOCK_SIZE);
+        _matched[i].reserve(limits.maxLines);
     }
 }
 
 size_t MTLockReadProcessor::execute(FileReader& freader, const std::string& filename,
-                            WildcardMatch& wcmatch, const std::string& pattern) {
+                                const CompiledPattern& cpattern, LineSink* sink) {
+
+    // other threads read blocks while a block is filtered
+    if(!freader.keepsLines()) {
+        errorAndStop("File reader doesn't keep lines of previous blocks", false);
+    }
 
     ScopedFileOpener fopener(freader, filename);
 
@@ -53,23 +73,15 @@ size_t MTLockReadProcessor::execute(FileReader& freader, const std::string& file
                 break;
             }
 
-            result += proctools::filterBlock(wcmatch, pattern, block);
+            result += proctools::filterBlock(cpattern, block, sink, _matched[idx]);
         }
 
         _counters[idx] = result;
     };
 
-    std::vector<std::thread> threads;
-    threads.reserve(_numOfThreads - 1);
-    for(size_t i = 0; i < _numOfThreads - 1; ++i) {
-        threads.emplace_back(threadFunc, i);
-    }
-
+    _pool->run(_numOfThreads - 1, threadFunc);
     threadFunc(_numOfThreads - 1);
-
-    for(auto& t: threads) {
-        t.join();
-    }
+    _pool->wait();
 
     return std::accumulate(_counters.begin(), _counters.end(),
                                 decltype(_counters)::value_type(0));
@@ -78,7 +90,7 @@ size_t MTLockReadProcessor::execute(FileReader& freader, const std::string& file
     size_t result = 0;
 
     #pragma omp parallel num_threads(_numOfThreads) \
-            shared(freader, wcmatch, pattern, _linesBlocks) \
+            shared(freader, cpattern, sink, _linesBlocks, _matched) \
             reduction(+:result)
     for(;;) {
 
@@ -93,7 +105,7 @@ size_t MTLockReadProcessor::execute(FileReader& freader, const std::string& file
             break;
         }
 
-        result += proctools::filterBlock(wcmatch, pattern, block);
+        result += proctools::filterBlock(cpattern, block, sink, _matched[idx]);
     }
 
     return result;
@@ -3,12 +3,15 @@
 #include <cstddef>
 #include <string>
 #include <vector>
+#include <memory>
 #include <mutex>
 
 #include "noncopyable.h"
 #include "linesblock.h"
 #include "wildcard.h"
 #include "filereader.h"
+#include "threadpool.h"
+#include "linesink.h"
 
 namespace fwc {
 
@@ -23,17 +26,28 @@ class MTLockReadProcessor final: private noncopyable
 {
 public:
 
-    MTLockReadProcessor(size_t numOfThreads, size_t maxLines, bool needsBuffer);
+    MTLockReadProcessor(size_t numOfThreads, BlockLimits limits, bool needsBuffer,
+                        ThreadPool* pool = nullptr);
 
+    // if the sink is not null found lines are written into it
     size_t execute(FileReader& freader, const std::string& filename,
-                    WildcardMatch& wcmatch, const std::string& pattern);
+                    const CompiledPattern& cpattern, LineSink* sink = nullptr);
+
+    size_t execute(FileReader& freader, const std::string& filename,
+                    const WildcardMatch& wcmatch, const std::string& pattern,
+                    LineSink* sink = nullptr) {
+        return execute(freader, filename, *wcmatch.compile(pattern), sink);
+    }
 
 private:
 
-    std::vector<LinesBlock> _linesBlocks;
-    std::vector<size_t>     _counters;
-    std::mutex              _mutex;
-    const size_t            _numOfThreads;
+    std::vector<LinesBlock>     _linesBlocks;
+    std::vector<MatchedLines>   _matched;
+    std::vector<size_t>         _counters;
+    std::mutex                  _mutex;
+    const size_t                _numOfThreads;
+    std::unique_ptr<ThreadPool> _ownPool;
+    ThreadPool*                 _pool;
 };
 
 } // namespace fwc
\ No newline at end of file
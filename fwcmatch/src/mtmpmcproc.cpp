@@ -10,10 +10,11 @@ namespace fwc {
 static LinesBlockPtr TERM_BLOCK = reinterpret_cast<LinesBlockPtr>(-1);
 
 MPMCProcessor::MPMCProcessor(size_t queueSize, size_t numOfConsThreads,
-                                            size_t maxLines, bool needsBuffer):
-    BaseProdConsProcessor(numOfConsThreads),
+                                            BlockLimits limits, bool needsBuffer,
+                                            ThreadPool* pool):
+    BaseProdConsProcessor(numOfConsThreads, pool),
     // for each block in queue and for each thread for waiting
-    _blocksPool(queueSize + numOfConsThreads + 1, maxLines),
+    _blocksPool(queueSize + numOfConsThreads + 1, limits),
     _blocksQueue(queueSize),
     _freeBlocks(_blocksPool.capacity()) {
 
@@ -49,7 +50,7 @@ void MPMCProcessor::readFileLines(FileReader& freader) {
         _freeBlocks.pop(block);
 
         assert(block);
-        proctools::readInLinesBlock(freader, *block);
+        readInLinesBlock(freader, *block);
         if(block->lines().empty()) {
             // end of file
 
@@ -68,8 +69,7 @@ void MPMCProcessor::readFileLines(FileReader& freader) {
     }
 }
 
-void MPMCProcessor::filterLines(size_t idx,
-                            WildcardMatch& wcmatch, const std::string& pattern) {
+void MPMCProcessor::filterLines(size_t idx, const CompiledPattern& cpattern) {
 
     size_t counter = 0;
     LinesBlockPtr block = nullptr;
@@ -88,7 +88,7 @@ void MPMCProcessor::filterLines(size_t idx,
         }
 
         assert(block);
-        counter += proctools::filterBlock(wcmatch, pattern, *block);
+        counter += filterBlock(idx, cpattern, *block);
         _freeBlocks.push(block);
     }
 
@@ -18,15 +18,15 @@ class MPMCProcessor final: public BaseProdConsProcessor
 {
 public:
     MPMCProcessor(size_t queueSize, size_t numOfConsThreads,
-                                        size_t maxLines, bool needsBuffer);
+                                        BlockLimits limits, bool needsBuffer,
+                                        ThreadPool* pool = nullptr);
 
 private:
 
     using BlockPtrsQueue = rigtorp::MPMCQueue<LinesBlockPtr>;
 
     void readFileLines(FileReader& freader) override;
-    void filterLines(size_t idx, WildcardMatch& wcmatch,
-                                        const std::string& pattern) override;
+    void filterLines(size_t idx, const CompiledPattern& cpattern) override;
 
     void init() override;
 
@@ -10,10 +10,11 @@ namespace fwc {
 static LinesBlockPtr TERM_BLOCK = reinterpret_cast<LinesBlockPtr>(-1);
 
 MTSemProcessor::MTSemProcessor(size_t queueSize, size_t numOfConsThreads,
-                                            size_t maxLines, bool needsBuffer):
-    BaseProdConsProcessor(numOfConsThreads),
+                                            BlockLimits limits, bool needsBuffer,
+                                            ThreadPool* pool):
+    BaseProdConsProcessor(numOfConsThreads, pool),
     // for each block in queue and for each thread for waiting
-    _blocksPool(queueSize + numOfConsThreads + 1, maxLines),
+    _blocksPool(queueSize + numOfConsThreads + 1, limits),
     _blocksQueue(queueSize) {
 
     assert(queueSize > 0);
@@ -21,23 +22,26 @@ MTSemProcessor::MTSemProcessor(size_t queueSize, size_t numOfConsThreads,
     _blocksPool.reset(needsBuffer);
 
     auto numOfThreads = numOfConsThreads + 1;
-    _firstBlocks.reserve(numOfThreads);
-    for(size_t i = 0; i < numOfThreads; ++i) {
-        _firstBlocks.push_back(_blocksPool.allocBlock());
+    _firstBlocks.resize(numOfThreads, nullptr);
+}
+
+void MTSemProcessor::init() {
+
+    _blocksPool.reset(false); // there is no need to allocate buffer here
+
+    // Pointers are mixed up by swapping in the previous run and
+    // the terminal block can be left in the queue so they are set again.
+    for(auto& block: _firstBlocks) {
+        block = _blocksPool.allocBlock();
     }
 
     // fill ring buffer with valid pointers
+    _blocksQueue.reset();
     for(size_t i = 0; i < _blocksQueue.capacity(); ++i) {
         _blocksQueue.push(_blocksPool.allocBlock());
     }
     // ring buffer must be empty
     _blocksQueue.reset();
-}
-
-void MTSemProcessor::init() {
-
-    _blocksPool.reset(false); // there is no need to allocate buffer here
-    _blocksQueue.reset();
 
     // I didn't find any other way to reset std::counting_semaphore objects
     _semEmpty = std::make_unique<Semaphore>(_blocksQueue.capacity());
@@ -52,7 +56,7 @@ void MTSemProcessor::readFileLines(FileReader& freader) {
     for(;;) {
 
         assert(block);
-        proctools::readInLinesBlock(freader, *block);
+        readInLinesBlock(freader, *block);
         if(block->lines().empty()) {
             // end of file
 
@@ -75,8 +79,7 @@ void MTSemProcessor::readFileLines(FileReader& freader) {
     }
 }
 
-void MTSemProcessor::filterLines(size_t idx,
-                            WildcardMatch& wcmatch, const std::string& pattern) {
+void MTSemProcessor::filterLines(size_t idx, const CompiledPattern& cpattern) {
 
     size_t counter = 0;
     LinesBlockPtr block = _firstBlocks[idx + 1];
@@ -108,7 +111,7 @@ void MTSemProcessor::filterLines(size_t idx,
         }
 
         assert(block);
-        counter += proctools::filterBlock(wcmatch, pattern, *block);
+        counter += filterBlock(idx, cpattern, *block);
     }
 
     _counters[idx] = counter;
@@ -21,7 +21,8 @@ class MTSemProcessor final: public BaseProdConsProcessor
 {
 public:
     MTSemProcessor(size_t queueSize, size_t numOfConsThreads,
-                                        size_t maxLines, bool needsBuffer);
+                                        BlockLimits limits, bool needsBuffer,
+                                        ThreadPool* pool = nullptr);
 
 private:
 
@@ -29,8 +30,7 @@ class MTSemProcessor final: public BaseProdConsProcessor
     using Semaphore     = std::counting_semaphore<>;
 
     void readFileLines(FileReader& freader) override;
-    void filterLines(size_t idx, WildcardMatch& wcmatch,
-                                        const std::string& pattern) override;
+    void filterLines(size_t idx, const CompiledPattern& cpattern) override;
 
     void init() override;
 
@@ -0,0 +1,153 @@
+#include <cassert>
+#include <thread>
+#include <utility>
+
+#include "proctools.h"
+#include "mtstealproc.h"
+
+namespace fwc {
+
+MTWorkStealingProcessor::MTWorkStealingProcessor(size_t queueSize, size_t numOfConsThreads,
+                                            BlockLimits limits, bool needsBuffer,
+                                            ThreadPool* pool):
+    BaseProdConsProcessor(numOfConsThreads, pool),
+    // for each block in queues and for each thread for waiting
+    _blocksPool(numOfConsThreads * (queueSize + 1) + 1, limits),
+    _freeBlocks(_blocksPool.capacity()) {
+
+    assert(queueSize > 0);
+
+    _blocksPool.reset(needsBuffer);
+
+    // a deque can hold all blocks and so pushing to it never fails
+    _consThreadInfo.reserve(numOfConsThreads);
+    for(size_t i = 0; i < numOfConsThreads; ++i) {
+        _consThreadInfo.push_back(
+                std::make_unique<ConsumerInfo>(queueSize, _blocksPool.capacity()));
+    }
+}
+
+void MTWorkStealingProcessor::init() {
+
+    _stop.store(false, std::memory_order_release);
+
+    for(auto& consInfo: _consThreadInfo) {
+        consInfo->reset();
+    }
+
+    _blocksPool.reset(false); // there is no need to allocate buffer here
+
+    LinesBlockPtr tmp;
+    while(!_freeBlocks.empty()) {
+        _freeBlocks.pop(tmp);
+    }
+    for(size_t i = 0; i < _blocksPool.capacity(); ++i) {
+        _freeBlocks.push(_blocksPool.allocBlock());
+    }
+}
+
+void MTWorkStealingProcessor::readFileLines(FileReader& freader) {
+
+    const auto numOfConsThreads = _consThreadInfo.size();
+    const size_t maxFailedPushes = numOfConsThreads * 1000;
+
+    size_t failedPushes = 0;
+    size_t consumerIdx = 0;
+    LinesBlockPtr block = nullptr;
+
+    for(;;) {
+
+        _freeBlocks.pop(block);
+
+        assert(block);
+        readInLinesBlock(freader, *block);
+        if(block->lines().empty()) {
+            // end of file
+            _freeBlocks.push(block);
+            break;
+        }
+
+        for(;;) {
+            auto& consInfo = *_consThreadInfo[consumerIdx];
+            consumerIdx = ++consumerIdx < numOfConsThreads ? consumerIdx: 0;
+
+            // std::as_const selects push of a value instead of push with a writer
+            if(consInfo.inbox.push(std::as_const(block))) {
+                failedPushes = 0;
+                break;
+            }
+
+            if(++failedPushes < maxFailedPushes) {
+                continue;
+            }
+
+            // usually it is useless function on a platform with more than one
+            // CPU core but because of busy-waiting it helps to decrease CPU load
+            std::this_thread::yield();
+        }
+    }
+
+    _stop.store(true, std::memory_order_release);
+}
+
+bool MTWorkStealingProcessor::stealBlock(size_t idx, LinesBlockPtr& block) {
+
+    const auto numOfConsThreads = _consThreadInfo.size();
+    for(size_t i = 1; i < numOfConsThreads; ++i) {
+        auto victimIdx = (idx + i) % numOfConsThreads;
+        if(_consThreadInfo[victimIdx]->blocks.steal(block)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MTWorkStealingProcessor::filterLines(size_t idx, const CompiledPattern& cpattern) {
+
+    constexpr size_t maxSpins = 1000;
+    auto& consInfo = *_consThreadInfo[idx];
+    size_t counter = 0;
+    size_t spinner = 0;
+    LinesBlockPtr block = nullptr;
+
+    for(;;) {
+
+        // It must be read before checking of the queues: if the producer has
+        // stopped then all its blocks are already visible in the inbox.
+        const bool stop = _stop.load(std::memory_order_acquire);
+
+        // move new blocks to the own deque where other consumers can steal them
+        while(consInfo.inbox.pop(block)) {
+            [[maybe_unused]] bool pushed = consInfo.blocks.push(block);
+            assert(pushed);
+        }
+
+        if(consInfo.blocks.pop(block) || stealBlock(idx, block)) {
+            assert(block);
+            counter += filterBlock(idx, cpattern, *block);
+            _freeBlocks.push(block);
+            spinner = 0;
+            continue;
+        }
+
+        if(stop) {
+            // Blocks left in deques of other consumers will be
+            // filtered by their owners.
+            break;
+        }
+
+        if(++spinner > maxSpins) {
+
+            // usually it is useless function on a platform with more than one
+            // CPU core but because of busy-waiting it helps to decrease CPU load
+            std::this_thread::yield();
+            spinner = 0;
+        }
+
+        // spin
+    }
+
+    _counters[idx] = counter;
+}
+
+} // namespace fwc
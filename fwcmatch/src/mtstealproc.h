@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+
+#include "rigtorp/MPMCQueue.h"
+
+#include "wfringbuffer.h"
+#include "wsdeque.h"
+#include "basepcproc.h"
+
+namespace fwc {
+
+/*
+This class implements work stealing between consumers. The producer hands
+blocks round-robin to per-consumer wait-free ring buffers (as
+MTLockFreeProcessor does) but each consumer moves new blocks from its ring
+buffer to its own Chase-Lev deque and takes them from there. When a consumer
+has nothing to do it steals blocks from deques of other consumers. So when
+some blocks are much slower to filter (long lines, heavy backtracking)
+other consumers don't wait for a slow one.
+
+There is no memory reallocation during processing.
+*/
+class MTWorkStealingProcessor final: public BaseProdConsProcessor
+{
+public:
+    MTWorkStealingProcessor(size_t queueSize, size_t numOfConsThreads,
+                                    BlockLimits limits, bool needsBuffer,
+                                    ThreadPool* pool = nullptr);
+
+private:
+
+    using WFBlockPtrsRing = WFSimpleRingBuffer<LinesBlockPtr>;
+    using BlockPtrsDeque  = WSDeque<LinesBlockPtr>;
+    using BlockPtrsQueue  = rigtorp::MPMCQueue<LinesBlockPtr>;
+
+    // specific info for each consumer's thread
+    struct ConsumerInfo final {
+        WFBlockPtrsRing inbox;
+        BlockPtrsDeque  blocks;
+
+        ConsumerInfo(size_t queueSize, size_t dequeSize):
+            inbox(queueSize), blocks(dequeSize) {}
+
+        // not thread safe
+        void reset() {
+            inbox.reset();
+            blocks.reset();
+        }
+    };
+
+    using ConsumerInfoUPtr     = std::unique_ptr<ConsumerInfo>;
+    using VectorOfConsumerInfo = std::vector<ConsumerInfoUPtr>;
+
+    void readFileLines(FileReader& freader) override;
+    void filterLines(size_t idx, const CompiledPattern& cpattern) override;
+
+    void init() override;
+
+    // try to steal a block from other consumers
+    bool stealBlock(size_t idx, LinesBlockPtr& block);
+
+    LinesBlockPool       _blocksPool;
+    BlockPtrsQueue       _freeBlocks;
+    VectorOfConsumerInfo _consThreadInfo;
+    std::atomic<bool>    _stop { false };
+};
+
+} // namespace fwc
@@ -0,0 +1,314 @@
+#include <cassert>
+#include <algorithm>
+
+#include "cpufeatures.h"
+#include "multipattern.h"
+
+#if FWC_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace fwc {
+
+MultiPattern::MultiPattern(const WildcardMatch& wcmatch, const PatternList& patterns) {
+
+    std::vector<std::string_view> literals;
+    for(auto const& pattern: patterns) {
+        _patterns.push_back(wcmatch.compile(pattern));
+
+        // literals refer to compiled patterns, so they are valid as long as them
+        auto literal = _patterns.back()->requiredLiteral();
+        if(literal.empty()) {
+            _literalIds.push_back(NO_LITERAL);
+            _hasAlwaysChecked = true;
+            continue;
+        }
+
+        // patterns with the same literal share it
+        auto it = std::find(literals.begin(), literals.end(), literal);
+        _literalIds.push_back(it - literals.begin());
+        if(it == literals.end()) {
+            literals.push_back(literal);
+        }
+    }
+
+    buildAutomaton(literals);
+    buildStartTables(literals);
+
+#if FWC_X86_SIMD
+    if(cpuHasAVX2()) {
+        _skip = &skipAVX2;
+    }
+#endif
+}
+
+void MultiPattern::buildAutomaton(const std::vector<std::string_view>& literals) {
+
+    _numLiterals = literals.size();
+
+    // bytes which are not in literals have class 0
+    _classes.assign(256, 0);
+    _numClasses = 1;
+    for(auto literal: literals) {
+        for(unsigned char c: literal) {
+            if(!_classes[c]) {
+                _classes[c] = _numClasses++;
+            }
+        }
+    }
+
+    // trie of literals, 0 means no edge because the root is not a child
+    std::vector<std::vector<std::uint32_t>> trie(1, std::vector<std::uint32_t>(_numClasses));
+    std::vector<std::vector<std::uint32_t>> outputs(1);
+    for(size_t id = 0; id < literals.size(); ++id) {
+        std::uint32_t state = 0;
+        for(unsigned char c: literals[id]) {
+            const auto cls = _classes[c];
+            if(!trie[state][cls]) {
+                const std::uint32_t next = trie.size();
+                trie.emplace_back(_numClasses);
+                outputs.emplace_back();
+                trie[state][cls] = next;
+            }
+            state = trie[state][cls];
+        }
+        outputs[state].push_back(id);
+    }
+
+    const size_t numStates = trie.size();
+    if(numStates * _numClasses >= OUTPUT_FLAG) {
+        errorAndStop("Too many patterns for one automaton", false);
+    }
+
+    // transitions of the automaton are built in breadth-first order, so
+    // transitions of the failure state of a state are ready before it
+    std::vector<std::uint32_t> table(numStates * _numClasses);
+    std::vector<std::uint32_t> failure(numStates);
+    std::vector<std::uint32_t> queue;
+    queue.reserve(numStates);
+
+    for(size_t cls = 0; cls < _numClasses; ++cls) {
+        if(auto child = trie[0][cls]) {
+            table[cls] = child;
+            queue.push_back(child);
+        }
+    }
+
+    for(size_t i = 0; i < queue.size(); ++i) {
+        const auto state = queue[i];
+        const auto* failTransitions = &table[failure[state] * _numClasses];
+        for(size_t cls = 0; cls < _numClasses; ++cls) {
+            const auto child = trie[state][cls];
+            if(!child) {
+                table[state * _numClasses + cls] = failTransitions[cls];
+                continue;
+            }
+
+            // literals which end in the failure state end here too
+            failure[child] = failTransitions[cls];
+            auto const& inherited = outputs[failure[child]];
+            outputs[child].insert(outputs[child].end(), inherited.begin(), inherited.end());
+
+            table[state * _numClasses + cls] = child;
+            queue.push_back(child);
+        }
+    }
+
+    // states are stored premultiplied by number of classes and with
+    // the flag if some literals end there
+    _table.resize(table.size());
+    for(size_t i = 0; i < table.size(); ++i) {
+        const auto next = table[i];
+        _table[i] = next * _numClasses | (outputs[next].empty() ? 0 : OUTPUT_FLAG);
+    }
+
+    _outputBegin.clear();
+    _outputs.clear();
+    for(auto const& output: outputs) {
+        _outputBegin.push_back(_outputs.size());
+        _outputs.insert(_outputs.end(), output.begin(), output.end());
+    }
+    _outputBegin.push_back(_outputs.size());
+}
+
+void MultiPattern::buildStartTables(const std::vector<std::string_view>& literals) {
+
+    _startBytes.fill(false);
+    for(auto literal: literals) {
+        _startBytes[static_cast<unsigned char>(literal[0])] = true;
+    }
+
+    // Each of 8 buckets is a bit, a byte is in the set if buckets of its
+    // nibbles intersect. Bytes with the same high nibble are in one bucket,
+    // so the check is exact for up to 8 high nibbles (all ASCII letters
+    // and digits have 3). Otherwise some bytes are found by mistake, it
+    // only makes skipping shorter.
+    _lowNibbles.fill(0);
+    _highNibbles.fill(0);
+    size_t numOfBuckets = 0;
+    std::array<int, 16> buckets;
+    buckets.fill(-1);
+    for(size_t c = 0; c < _startBytes.size(); ++c) {
+        if(!_startBytes[c]) {
+            continue;
+        }
+        auto& bucket = buckets[c >> 4];
+        if(bucket < 0) {
+            bucket = numOfBuckets++ % 8;
+        }
+        _highNibbles[c >> 4] |= 1 << bucket;
+        _lowNibbles[c & 0xf] |= 1 << bucket;
+    }
+}
+
+const char* MultiPattern::skipScalar(const MultiPattern& self,
+                                        const char* begin, const char* end) {
+    while(begin < end && !self._startBytes[static_cast<unsigned char>(*begin)]) {
+        ++begin;
+    }
+    return begin;
+}
+
+#if FWC_X86_SIMD
+
+__attribute__((target("avx2")))
+const char* MultiPattern::skipAVX2(const MultiPattern& self,
+                                        const char* begin, const char* end) {
+
+    constexpr ptrdiff_t width = sizeof(__m256i);
+
+    const __m256i lowTable  = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(self._lowNibbles.data())));
+    const __m256i highTable = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(self._highNibbles.data())));
+    const __m256i nibble    = _mm256_set1_epi8(0x0f);
+    const __m256i zero      = _mm256_setzero_si256();
+
+    for(; end - begin >= width; begin += width) {
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        auto low   = _mm256_shuffle_epi8(lowTable, _mm256_and_si256(block, nibble));
+        auto high  = _mm256_shuffle_epi8(highTable,
+                            _mm256_and_si256(_mm256_srli_epi16(block, 4), nibble));
+        unsigned mask = ~_mm256_movemask_epi8(
+                            _mm256_cmpeq_epi8(_mm256_and_si256(low, high), zero));
+        if(mask) {
+            return begin + __builtin_ctz(mask);
+        }
+    }
+
+    // the rest is shorter than one AVX2 vector
+    return skipScalar(self, begin, end);
+}
+
+#else
+
+const char* MultiPattern::skipAVX2(const MultiPattern& self,
+                                        const char* begin, const char* end) {
+    return skipScalar(self, begin, end);
+}
+
+#endif
+
+const std::uint64_t* MultiPattern::findLiterals(std::string_view text) const {
+
+    if(!_numLiterals) {
+        return nullptr;
+    }
+
+    thread_local std::vector<std::uint64_t> found;
+    const size_t words = (_numLiterals + 63) / 64;
+    if(found.size() < words) {
+        found.resize(words);
+    }
+
+    const auto* table   = _table.data();
+    const auto* classes = _classes.data();
+
+    const char* pos = text.data();
+    const char* end = pos + text.size();
+
+    bool          any   = false;
+    std::uint32_t state = 0;
+    while(pos < end) {
+        if(!state) {
+            // nothing is found yet here, so only a literal beginning is interesting
+            pos = _skip(*this, pos, end);
+            if(pos == end) {
+                break;
+            }
+        }
+
+        state = table[state + classes[static_cast<unsigned char>(*pos++)]];
+        if(!(state & OUTPUT_FLAG)) {
+            continue;
+        }
+
+        state &= ~OUTPUT_FLAG;
+        if(!any) {
+            std::fill_n(found.begin(), words, 0);
+            any = true;
+        }
+
+        const size_t idx = state / _numClasses;
+        for(auto i = _outputBegin[idx]; i < _outputBegin[idx + 1]; ++i) {
+            const auto literal = _outputs[i];
+            found[literal / 64] |= std::uint64_t(1) << (literal % 64);
+        }
+    }
+
+    return any ? found.data() : nullptr;
+}
+
+// Threads get shards in turn, so threads of a processor usually don't share them
+static size_t threadShard(size_t numOfShards) noexcept {
+
+    static std::atomic<size_t> nextShard { 0 };
+    thread_local const size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed);
+
+    return shard % numOfShards;
+}
+
+MultiPatternCounter::MultiPatternCounter(const MultiPattern& patterns):
+    _patterns(patterns),
+    _linesPerShard((patterns.size() + COUNTERS_PER_LINE - 1) / COUNTERS_PER_LINE),
+    _counters(NUM_SHARDS * _linesPerShard) {
+}
+
+std::vector<size_t> MultiPatternCounter::counts() const {
+
+    std::vector<size_t> result(_patterns.size());
+    for(size_t shard = 0; shard < NUM_SHARDS; ++shard) {
+        const auto* lines = &_counters[shard * _linesPerShard];
+        for(size_t idx = 0; idx < result.size(); ++idx) {
+            auto const& counter = lines[idx / COUNTERS_PER_LINE].values[idx % COUNTERS_PER_LINE];
+            result[idx] += counter.load(std::memory_order_relaxed);
+        }
+    }
+
+    return result;
+}
+
+void MultiPatternCounter::reset() noexcept {
+    for(auto& line: _counters) {
+        for(auto& counter: line.values) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool MultiPatternCounter::isMatchImpl(const std::string_view& text) const {
+
+    // the shard is taken only for matched lines
+    CountersLine* lines = nullptr;
+    _patterns.forEachMatch(text, [&](size_t idx) {
+        if(!lines) {
+            lines = &_counters[threadShard(NUM_SHARDS) * _linesPerShard];
+        }
+        lines[idx / COUNTERS_PER_LINE].values[idx % COUNTERS_PER_LINE]
+                                        .fetch_add(1, std::memory_order_relaxed);
+    });
+
+    return lines != nullptr;
+}
+
+} // namespace fwc
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <atomic>
+
+#include "noncopyable.h"
+#include "utils.h"
+#include "wildcard.h"
+
+namespace fwc {
+
+/*
+Matching of a lot of patterns with each line in one pass.
+Required literals of all patterns are gathered into one Aho-Corasick
+automaton. It is a dense table of transitions by classes of bytes (only
+bytes of the literals have their own classes), so a line is scanned once
+with one table lookup per byte whatever the number of patterns is.
+While the automaton is in the root state bytes which can't begin any
+literal are skipped. With AVX2 (selected at runtime) 32 bytes are checked
+at once by their nibbles with two shuffle tables ("shufti" of Hyperscan).
+The full pattern is matched only if its literal is found in the line.
+Patterns without a required literal are matched with each line.
+It is immutable after creation and so it is thread safe.
+*/
+
+class MultiPattern final: private noncopyable
+{
+public:
+
+    using PatternList = std::vector<std::string>;
+
+    MultiPattern(const WildcardMatch& wcmatch, const PatternList& patterns);
+
+    [[nodiscard]]
+    size_t size() const noexcept { return _patterns.size(); }
+
+    [[nodiscard]]
+    const CompiledPattern& pattern(size_t idx) const { return *_patterns[idx]; }
+
+    // Call 'func(idx)' for each pattern which matches the text,
+    // indexes are in ascending order
+    template<typename Func>
+    void forEachMatch(std::string_view text, Func&& func) const;
+
+private:
+
+    constexpr static std::uint32_t NO_LITERAL  = UINT32_MAX;
+    constexpr static std::uint32_t OUTPUT_FLAG = 1u << 31;
+
+    using SkipFunc = const char* (*)(const MultiPattern&, const char*, const char*);
+
+    void buildAutomaton(const std::vector<std::string_view>& literals);
+    void buildStartTables(const std::vector<std::string_view>& literals);
+
+    // the first byte in [begin, end) which can begin a literal or 'end'
+    static const char* skipScalar(const MultiPattern& self,
+                                        const char* begin, const char* end);
+    static const char* skipAVX2(const MultiPattern& self,
+                                        const char* begin, const char* end);
+
+    // Scan the text with the automaton, returns bit set of found literals
+    // (it's thread local) or nullptr if no one is found
+    const std::uint64_t* findLiterals(std::string_view text) const;
+
+    std::vector<CompiledPatternPtr> _patterns;
+    std::vector<std::uint32_t>      _literalIds;   // for each pattern
+    std::vector<std::uint16_t>      _classes;      // byte -> class
+    std::vector<std::uint32_t>      _table;        // state * numClasses + class
+    std::vector<std::uint32_t>      _outputBegin;  // for each state
+    std::vector<std::uint32_t>      _outputs;      // literal ids
+    std::array<bool, 256>           _startBytes   {};
+    std::array<std::uint8_t, 16>    _lowNibbles   {}; // buckets of bytes by low nibbles
+    std::array<std::uint8_t, 16>    _highNibbles  {}; // by high nibbles
+    SkipFunc                        _skip         { &skipScalar };
+    size_t                          _numClasses   { 1 };
+    size_t                          _numLiterals  { 0 };
+    bool                            _hasAlwaysChecked { false };
+};
+
+/*
+Pattern which counts lines matched by each pattern of MultiPattern, a line
+is matched if any of them matches it. So it can be passed to any processor
+to get numbers for all patterns with one read of a file, found lines are
+written into a sink as usual.
+Unlike other compiled patterns it has state (counters) but it is still
+thread safe. Counters are atomic and split into shards, threads are spread
+over shards to avoid false sharing.
+*/
+
+class MultiPatternCounter final: public CompiledPattern
+{
+public:
+
+    explicit MultiPatternCounter(const MultiPattern& patterns);
+
+    // numbers of matched lines for each pattern since creation or reset
+    [[nodiscard]]
+    std::vector<size_t> counts() const;
+
+    // it must not be called while lines are matched
+    void reset() noexcept;
+
+private:
+
+    constexpr static size_t NUM_SHARDS = 16;
+    constexpr static size_t COUNTERS_PER_LINE = CACHE_LINE_SIZE / sizeof(std::atomic<size_t>);
+
+    struct alignas(CACHE_LINE_SIZE) CountersLine final {
+        std::atomic<size_t> values[COUNTERS_PER_LINE];
+    };
+
+    bool isMatchImpl(const std::string_view& text) const override;
+
+    const MultiPattern&               _patterns;
+    const size_t                      _linesPerShard;
+    mutable std::vector<CountersLine> _counters;
+};
+
+/// Inline implementation
+
+template<typename Func>
+void MultiPattern::forEachMatch(std::string_view text, Func&& func) const {
+
+    const std::uint64_t* found = findLiterals(text);
+    if(!found && !_hasAlwaysChecked) {
+        return;
+    }
+
+    for(size_t idx = 0; idx < _patterns.size(); ++idx) {
+        const auto literal = _literalIds[idx];
+        if(literal != NO_LITERAL &&
+                (!found || !((found[literal / 64] >> (literal % 64)) & 1))) {
+            continue;
+        }
+        if(_patterns[idx]->isMatch(text)) {
+            func(idx);
+        }
+    }
+}
+
+} // namespace fwc
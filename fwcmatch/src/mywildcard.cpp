@@ -1,56 +1,355 @@
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <string_view>
+#include <vector>
 
+#include "charclass.h"
+#include "cpufeatures.h"
 #include "mywildcard.h"
-#include <cassert>
+
+#if FWC_X86_SIMD
+#include <immintrin.h>
+#endif
 
 namespace fwc {
 
-bool MyWildcardMatch::isMatchImpl(const std::string_view& text, const std::string& pattern) const {
+namespace {
 
-    const char* ppattern = pattern.c_str();
-    const char* ptext    = text.cbegin();
+/*
+The pattern is split by '*' into segments: P0*P1*...*Pn.
+Each segment has fixed length (it can contain only ordinary characters, '?'
+and '[...]') and so the text matches the pattern if it starts with P0, ends
+with Pn and P1...Pn-1 can be found in this order between them. It is enough
+to search for each segment from the left to the right without any
+backtracking because the leftmost position of a segment leaves as much text
+as possible for the rest of segments.
+Case insensitive matching doesn't copy texts: bytes of texts are folded
+by a table while they are compared and by SSE2 while a segment is searched.
+*/
 
-    const char* textpos = nullptr;
-    const char* starpos = nullptr;
+struct Segment final {
+    std::string          text;      // bytes, letters are in lower case for case insensitive matching
+    std::vector<ByteSet> sets;      // for each byte if there are '?' or '[...]', otherwise empty
+    bool                 foldCase { false }; // text has letters and the case is ignored
+
+    // positions of ordinary bytes and of bytes which are checked by sets
+    std::vector<std::uint32_t> fixed;
+    std::vector<std::uint32_t> classes;
+
+    // Split positions by the kind of check or remove sets if there are
+    // only ordinary bytes
+    void finish(bool hasSets) {
+        if(!hasSets) {
+            sets.clear();
+            return;
+        }
+        for(std::uint32_t idx = 0; idx < sets.size(); ++idx) {
+            if(isFixed(idx)) {
+                fixed.push_back(idx);
+            }
+            else if(!sets[idx].all()) {
+                classes.push_back(idx);
+            }
+        }
+    }
 
-    while(ptext != text.cend()) {
-        if(*ptext == *ppattern || '?' == *ppattern) {
-            // Just go forward through the text and the pattern.
-            ++ptext;
-            ++ppattern;
+    // the byte at the position is the same in all matched texts
+    bool isFixed(size_t idx) const noexcept {
+        if(!sets.empty()) {
+            return sets[idx].count() == 1;
         }
-        else if('*' == *ppattern) {
-            if(! *++ppattern) {
-                // We have '*' at the end of the pattern and can just get out fast.
-                // This allow us to speed up parsing of a long text with '*' at
-                // the end in a pattern.
-                return true;
+        return !foldCase || !isAsciiLetter(text[idx]);
+    }
+
+    // compare with the text at the position, the text must be long enough
+    bool equalsAt(const char* ptext) const noexcept {
+        if(!sets.empty()) {
+            // ordinary bytes are cheaper to check, '?' is not checked at all
+            for(auto idx: fixed) {
+                if(ptext[idx] != text[idx]) {
+                    return false;
+                }
             }
+            for(auto idx: classes) {
+                if(!sets[idx][static_cast<unsigned char>(ptext[idx])]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        if(!foldCase) {
+            return 0 == std::memcmp(ptext, text.data(), text.size());
+        }
+
+        for(size_t i = 0; i < text.size(); ++i) {
+            if(CASE_FOLD[static_cast<unsigned char>(ptext[i])] !=
+                                        static_cast<unsigned char>(text[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // find the leftmost position of the segment in the text
+    const char* find(const char* begin, const char* end) const noexcept {
+
+        const size_t size = text.size();
+        if(static_cast<size_t>(end - begin) < size) {
+            return nullptr;
+        }
 
-            starpos = ppattern;
+        if(sets.empty() && !foldCase) {
+            return static_cast<const char*>(
+                        ::memmem(begin, end - begin, text.data(), size));
+        }
+
+        const char* last = end - size;
+        if(sets.empty()) {
+            begin = findFolded(begin, last);
+        }
+        else if(!fixed.empty()) {
+            // candidates have the first ordinary byte at its place
+            const size_t idx = fixed.front();
+            while(begin <= last) {
+                auto found = static_cast<const char*>(
+                                std::memchr(begin + idx, text[idx], last - begin + 1));
+                if(!found) {
+                    return nullptr;
+                }
+                begin = found - idx;
+                if(equalsAt(begin)) {
+                    return begin;
+                }
+                ++begin;
+            }
+            return nullptr;
+        }
 
-            // We don't shift text pointer here because * also means zero characters.
-            textpos = ptext;
+        for(; begin <= last; ++begin) {
+            if(equalsAt(begin)) {
+                return begin;
+            }
         }
-        else if(starpos) {
-            // There was * so we return back to the old position with '*'.
-            ppattern = starpos;
-            // Shift saved text position and set to the current text pointer.
-            ptext = ++textpos;
+        return nullptr;
+    }
+
+private:
+    // Skip positions in [begin, last] where the first and the last bytes
+    // of the text differ from the segment ignoring the case
+    const char* findFolded(const char* begin, const char* last) const noexcept {
+#if FWC_X86_SIMD
+        constexpr ptrdiff_t width = sizeof(__m128i);
+
+        const size_t  lastIdx = text.size() - 1;
+        const __m128i first   = _mm_set1_epi8(text.front());
+        const __m128i back    = _mm_set1_epi8(text.back());
+
+        // 'A'-'Z' get 0x20, bytes above 0x7f are negative and are not changed
+        auto toLower = [](__m128i block) {
+            auto upper = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('A' - 1)),
+                                        _mm_cmplt_epi8(block, _mm_set1_epi8('Z' + 1)));
+            return _mm_or_si128(block, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+        };
+
+        for(; last - begin >= width; begin += width) {
+            auto block1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            auto block2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + lastIdx));
+            auto eq     = _mm_and_si128(_mm_cmpeq_epi8(toLower(block1), first),
+                                        _mm_cmpeq_epi8(toLower(block2), back));
+            for(unsigned mask = _mm_movemask_epi8(eq); mask; mask &= mask - 1) {
+                const char* candidate = begin + __builtin_ctz(mask);
+                if(equalsAt(candidate)) {
+                    return candidate;
+                }
+            }
+        }
+#else
+        (void)last;
+#endif
+        // the rest is checked by the caller
+        return begin;
+    }
+};
+
+class MyCompiledPattern final: public CompiledPattern
+{
+public:
+    MyCompiledPattern(const std::string& pattern, bool ignoreCase);
+
+    std::string_view requiredLiteral() const override { return _literal; }
+
+private:
+    bool isMatchImpl(const std::string_view& text) const override;
+
+    // Split the pattern into segments, each one has the same number of
+    // bytes in 'text' and in 'sets' (see Segment::finish)
+    std::vector<Segment> parse(std::string_view pattern, bool ignoreCase);
+
+    // find the longest part of segments with fixed bytes
+    void findRequiredLiteral();
+
+    std::string_view     _literal;
+    Segment              _head;      // before the first '*'
+    Segment              _tail;      // after the last '*'
+    std::vector<Segment> _middle;    // between '*'
+    size_t               _minSize { 0 };
+    bool                 _hasStar { false };
+};
+
+MyCompiledPattern::MyCompiledPattern(const std::string& pattern, bool ignoreCase):
+    CompiledPattern(pattern) {
+
+    auto segments = parse(pattern, ignoreCase);
+
+    _head = std::move(segments.front());
+    if(segments.size() > 1) {
+        _tail = std::move(segments.back());
+        _middle.assign(std::make_move_iterator(segments.begin() + 1),
+                        std::make_move_iterator(segments.end() - 1));
+    }
+
+    findRequiredLiteral();
+}
+
+std::vector<Segment> MyCompiledPattern::parse(std::string_view pattern, bool ignoreCase) {
+
+    std::vector<Segment> segments(1);
+    std::vector<bool>    hasSets(1, false);
+
+    auto addByte = [&](unsigned char c) {
+        auto& segment = segments.back();
+        ByteSet set;
+        set.set(c);
+        if(ignoreCase) {
+            addOtherCase(set);
+            segment.foldCase = segment.foldCase || isAsciiLetter(c);
+        }
+        segment.text.push_back(ignoreCase ? CASE_FOLD[c] : c);
+        segment.sets.push_back(set);
+    };
+
+    // sets are made with the case in mind
+    auto addSet = [&](ByteSet set) {
+        if(set.count() == 1) {
+            // like '[*]', it's an ordinary byte
+            size_t c = 0;
+            while(!set[c]) {
+                ++c;
+            }
+            addByte(c);
+            return;
+        }
+        segments.back().text.push_back('?');
+        segments.back().sets.push_back(std::move(set));
+        hasSets.back() = true;
+    };
+
+    for(size_t i = 0; i < pattern.size(); ++i) {
+        const char c = pattern[i];
+        if('*' == c) {
+            _hasStar = true;
+            if(!segments.back().text.empty() || segments.size() == 1) {
+                segments.emplace_back();
+                hasSets.push_back(false);
+            }
+            continue;
+        }
+
+        ++_minSize;
+        if('?' == c) {
+            addSet(ByteSet().set());
+        }
+        else if('[' == c) {
+            ByteSet set;
+            auto next = parseBracket(pattern, i, true, ignoreCase, set);
+            if(next == std::string_view::npos) {
+                addByte(c);
+                continue;
+            }
+            addSet(std::move(set));
+            i = next - 1;
+        }
+        else if('\\' == c && i + 1 < pattern.size()) {
+            // the next byte is ordinary, a trailing '\' is ordinary itself
+            addByte(pattern[++i]);
         }
         else {
-            // match wasn't found
-            return false;
+            addByte(c);
         }
     }
 
-    // Handle tail of '*' in the pattern: we went through the whole text but
-    // not through the pattern and it can contain '*' at the end yet.
-    while('*' == *ppattern) {
-        ++ppattern;
+    for(size_t i = 0; i < segments.size(); ++i) {
+        segments[i].finish(hasSets[i]);
     }
 
-    // Return true if we went through the whole pattern.
-    return !*ppattern;
+    return segments;
+}
+
+void MyCompiledPattern::findRequiredLiteral() {
+
+    auto check = [&](const Segment& segment) {
+        const std::string_view text = segment.text;
+        for(size_t begin = 0; begin < text.size(); ) {
+            size_t end = begin;
+            while(end < text.size() && segment.isFixed(end)) {
+                ++end;
+            }
+            if(end - begin > _literal.size()) {
+                _literal = text.substr(begin, end - begin);
+            }
+            begin = end + 1;
+        }
+    };
+
+    check(_head);
+    for(auto const& segment: _middle) {
+        check(segment);
+    }
+    check(_tail);
+}
+
+bool MyCompiledPattern::isMatchImpl(const std::string_view& text) const {
+
+    if(text.size() < _minSize) {
+        return false;
+    }
+
+    const char* begin = text.data();
+    const char* end   = begin + text.size();
+
+    if(!_hasStar) {
+        return text.size() == _head.text.size() && _head.equalsAt(begin);
+    }
+
+    if(!_head.equalsAt(begin)) {
+        return false;
+    }
+    begin += _head.text.size();
+
+    // _minSize guarantees that the tail does not overlap the head
+    end -= _tail.text.size();
+    if(!_tail.equalsAt(end)) {
+        return false;
+    }
+
+    for(auto const& segment: _middle) {
+        begin = segment.find(begin, end);
+        if(!begin) {
+            return false;
+        }
+        begin += segment.text.size();
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+CompiledPatternPtr MyWildcardMatch::compile(const std::string& pattern) const {
+    return std::make_unique<MyCompiledPattern>(pattern, _ignoreCase);
 }
 
-} // namespace fwc
\ No newline at end of file
+} // namespace fwc
@@ -4,12 +4,22 @@
 
 namespace fwc {
 
+// Patterns can have '*', '?', '[...]' (see parseBracket) and '\' to make
+// the next byte ordinary. ASCII letters are matched in any case if
+// 'ignoreCase' is true.
 // Thread safe
 class MyWildcardMatch final: public WildcardMatch
 {
+public:
+    explicit MyWildcardMatch(bool ignoreCase = false) noexcept:
+        _ignoreCase(ignoreCase) {
+    }
+
+    [[nodiscard]]
+    CompiledPatternPtr compile(const std::string& pattern) const override;
+
 private:
-    bool isMatchImpl(const std::string_view& text,
-                                const std::string& pattern) const override;
+    const bool _ignoreCase;
 };
 
-} // namespace fwc
\ No newline at end of file
+} // namespace fwc
@@ -0,0 +1,139 @@
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#include "cpufeatures.h"
+#include "newlineindex.h"
+
+#if FWC_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace fwc {
+
+NewlineIndex::NewlineIndex(size_t capacity): _positions(capacity) {
+#if FWC_X86_SIMD
+    _scan = cpuHasAVX2() ? &scanAVX2 : &scanSSE2;
+#endif
+}
+
+size_t NewlineIndex::build(const char* begin, const char* end, size_t maxCount) {
+
+    assert(begin <= end);
+    assert(static_cast<size_t>(end - begin) <= UINT32_MAX);
+
+    maxCount = std::min(maxCount, _positions.size());
+    if(!maxCount) {
+        return 0;
+    }
+
+    return _scan(begin, end, _positions.data(), maxCount);
+}
+
+size_t NewlineIndex::scanScalar(const char* begin, const char* end,
+                                std::uint32_t* positions, size_t maxCount) {
+
+    size_t count = 0;
+    for(const char* pos = begin; count < maxCount && pos < end; ++pos) {
+        pos = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+        if(!pos) {
+            break;
+        }
+        positions[count++] = pos - begin;
+    }
+
+    return count;
+}
+
+#if FWC_X86_SIMD
+
+// write positions of bits from the mask, returns false if maxCount is reached
+static inline bool addPositions(unsigned mask, std::uint32_t base,
+                    std::uint32_t* positions, size_t& count, size_t maxCount) {
+    while(mask) {
+        positions[count++] = base + __builtin_ctz(mask);
+        if(count == maxCount) {
+            return false;
+        }
+        mask &= mask - 1;
+    }
+    return true;
+}
+
+size_t NewlineIndex::scanSSE2(const char* begin, const char* end,
+                                std::uint32_t* positions, size_t maxCount) {
+
+    constexpr ptrdiff_t width = sizeof(__m128i);
+
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    size_t count = 0;
+    const char* pos = begin;
+    for(; end - pos >= width; pos += width) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+        if(mask && !addPositions(mask, pos - begin, positions, count, maxCount)) {
+            return count;
+        }
+    }
+
+    // the rest is shorter than one SSE2 vector
+    const size_t tail = scanScalar(pos, end, positions + count, maxCount - count);
+    for(size_t i = count; i < count + tail; ++i) {
+        positions[i] += pos - begin;
+    }
+
+    return count + tail;
+}
+
+__attribute__((target("avx2")))
+size_t NewlineIndex::scanAVX2(const char* begin, const char* end,
+                                std::uint32_t* positions, size_t maxCount) {
+
+    constexpr ptrdiff_t width = sizeof(__m256i);
+
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    size_t count = 0;
+    const char* pos = begin;
+    for(; end - pos >= 2 * width; pos += 2 * width) {
+        // two vectors per iteration, there are usually no newlines in both
+        auto block1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        auto block2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos + width));
+        unsigned mask1 = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block1, newline));
+        unsigned mask2 = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block2, newline));
+        if(!(mask1 | mask2)) {
+            continue;
+        }
+        if(mask1 && !addPositions(mask1, pos - begin, positions, count, maxCount)) {
+            return count;
+        }
+        if(mask2 && !addPositions(mask2, pos + width - begin, positions, count, maxCount)) {
+            return count;
+        }
+    }
+
+    // the rest is shorter than two AVX2 vectors
+    const size_t tail = scanSSE2(pos, end, positions + count, maxCount - count);
+    for(size_t i = count; i < count + tail; ++i) {
+        positions[i] += pos - begin;
+    }
+
+    return count + tail;
+}
+
+#else
+
+size_t NewlineIndex::scanSSE2(const char* begin, const char* end,
+                                std::uint32_t* positions, size_t maxCount) {
+    return scanScalar(begin, end, positions, maxCount);
+}
+
+size_t NewlineIndex::scanAVX2(const char* begin, const char* end,
+                                std::uint32_t* positions, size_t maxCount) {
+    return scanScalar(begin, end, positions, maxCount);
+}
+
+#endif
+
+} // namespace fwc
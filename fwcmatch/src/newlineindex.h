@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fwc {
+
+/*
+Bulk search of newlines. A buffer is scanned with SSE2/AVX2 (selected at
+runtime) compare and movemask, and offsets of all newlines are written into
+a compact array in one pass. So splitting of a buffer with short lines
+doesn't pay for a memchr call per line.
+Offsets are 32 bits, so one scan covers less than 4 GB.
+*/
+class NewlineIndex final
+{
+public:
+
+    // capacity is the maximum number of newlines found by one scan
+    explicit NewlineIndex(size_t capacity = 0);
+
+    // Find up to 'maxCount' newlines in [begin, end), maxCount is limited
+    // by capacity, end - begin must be less than 4 GB.
+    // Returns number of found newlines.
+    size_t build(const char* begin, const char* end, size_t maxCount);
+
+    void reserve(size_t capacity) { _positions.resize(capacity); }
+
+    [[nodiscard]]
+    size_t capacity() const noexcept { return _positions.size(); }
+
+    // offset of the idx-th found newline from 'begin' of the last scan
+    [[nodiscard]]
+    std::uint32_t operator[](size_t idx) const noexcept { return _positions[idx]; }
+
+private:
+    using ScanFunc = size_t (*)(const char*, const char*, std::uint32_t*, size_t);
+
+    static size_t scanScalar(const char* begin, const char* end,
+                                std::uint32_t* positions, size_t maxCount);
+    static size_t scanSSE2(const char* begin, const char* end,
+                                std::uint32_t* positions, size_t maxCount);
+    static size_t scanAVX2(const char* begin, const char* end,
+                                std::uint32_t* positions, size_t maxCount);
+
+    std::vector<std::uint32_t> _positions;
+    ScanFunc                   _scan { &scanScalar };
+};
+
+} // namespace fwc
@@ -1,21 +1,36 @@
 
 #include <cassert>
+#include <cstring>
 
+#include "utils.h"
 #include "proctools.h"
 
 namespace fwc {
 namespace proctools {
 
-void readInLinesBlock(FileReader& freader, LinesBlock& block) {
+// lines which begin after the byte budget of a block go to the next block
+static size_t limitEndOffset(size_t offset, size_t maxBytes, size_t endOffset) {
+    return offset < endOffset && endOffset - offset > maxBytes ? offset + maxBytes : endOffset;
+}
+
+void readInLinesBlock(FileReader& freader, LinesBlock& block, size_t endOffset) {
 
     const bool needsBuffer = freader.needsBuffer();
     const auto maxLines = block.maxLines();
+    endOffset = limitEndOffset(freader.offset(), block.maxBytes(), endOffset);
 
     auto& buffer = block.buffer();
     auto* bufferPtr = needsBuffer ? buffer.get(0) : nullptr;
     size_t lastLineSize = 0;
 
     block.clear();
+    block.setFirstLineNo(freader.linesRead());
+    freader.setOverflow(needsBuffer ? &block.overflow() : nullptr);
+    freader.startBlock();
+    if(freader.readLines(block, maxLines, endOffset)) {
+        return;
+    }
+
     for(size_t i = 0; i < maxLines; ++i) {
         if(needsBuffer) {
             //freader.setBuffer(buffer.get(i), buffer.blockSize());
@@ -24,13 +39,76 @@ void readInLinesBlock(FileReader& freader, LinesBlock& block) {
             bufferPtr += lastLineSize;
             freader.setBuffer(bufferPtr, buffer.blockSize());
         }
+        const auto offset = freader.offset();
+        if(offset >= endOffset) {
+            break;
+        }
         auto line = freader.readLine();
         if(!line.data()) {
             break;
         }
-        lastLineSize = line.size();
-        block.addLine(std::move(line));
+        // long lines are in the overflow arena
+        lastLineSize = buffer.owns(line.data()) ? line.size() : 0;
+        block.addLine(line, offset);
+    }
+}
+
+void readInLinesBlock(FileReader& freader, CompactLinesBlock& block, size_t endOffset) {
+
+    endOffset = limitEndOffset(freader.offset(), block.maxBytes(), endOffset);
+    block.clear();
+    block.setFirstLineNo(freader.linesRead());
+    freader.startBlock();
+    if(!freader.readLines(block, block.maxLines(), endOffset)) {
+        errorAndStop("File reader doesn't support compact lines blocks", false);
+    }
+}
+
+// Get line which begins at 'pos' and
+// set 'pos' to the beginning of the next line
+static inline FileLineRef nextLine(const char*& pos, const char* end) {
+
+    const char* eol = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+    const char* lineEnd = eol ? eol : end;
+
+    FileLineRef line { pos, static_cast<size_t>(lineEnd - pos) };
+    if(eol && eol != pos && *(eol - 1) == '\r') {
+        line.remove_suffix(1);
+    }
+
+    pos = eol ? eol + 1 : end;
+    return line;
+}
+
+size_t filterBuffer(const CompiledPattern& cpattern, const LiteralSearcher* searcher,
+                                                        std::string_view buffer) {
+
+    const char* pos = buffer.data();
+    const char* end = pos + buffer.size();
+    size_t counter = 0;
+
+    if(!searcher) {
+        // nothing to search, so just go through all lines
+        while(pos < end) {
+            counter += cpattern.isMatch(nextLine(pos, end));
+        }
+        return counter;
+    }
+
+    // here 'pos' is always the beginning of a line
+    while(pos < end) {
+        const char* found = searcher->find(pos, end);
+        if(!found) {
+            break;
+        }
+
+        auto lineBegin = static_cast<const char*>(::memrchr(pos, '\n', found - pos));
+        pos = lineBegin ? lineBegin + 1 : pos;
+
+        counter += cpattern.isMatch(nextLine(pos, end));
     }
+
+    return counter;
 }
 
 } // namespace proctools
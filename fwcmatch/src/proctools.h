@@ -1,36 +1,146 @@
 #pragma once
 
+#include <cassert>
 #include <cstddef>
 #include <string>
 #include <algorithm>
+#include <limits>
 
 #include "linesblock.h"
+#include "literalsearch.h"
 #include "wildcard.h"
 #include "filereader.h"
+#include "linesink.h"
 
 namespace fwc {
 namespace proctools {
 
 // Read file lines in a block
-void readInLinesBlock(FileReader& freader, LinesBlock& block);
+// Lines which begin at 'endOffset' or after it are not read, the same is
+// for the byte budget of the block.
+void readInLinesBlock(FileReader& freader, LinesBlock& block,
+                        size_t endOffset = std::numeric_limits<size_t>::max());
+
+// Read file lines in a block with compact layout, the reader must support
+// it (MMapReader).
+void readInLinesBlock(FileReader& freader, CompactLinesBlock& block,
+                        size_t endOffset = std::numeric_limits<size_t>::max());
 
 // Filter lines from a block
 // Returns number of found lines according pattern
-size_t filterBlock(WildcardMatch& wcmatch, const std::string& pattern,
-                                                        LinesBlock const& block);
+size_t filterBlock(const CompiledPattern& cpattern, LinesBlock const& block);
+size_t filterBlock(const CompiledPattern& cpattern, CompactLinesBlock const& block);
+
+// Filter lines from a block and put found lines into 'matched' (it's
+// cleared before). Capacity of 'matched' is expected to be not less than
+// block.maxLines() to avoid memory allocation.
+// Returns number of found lines according pattern
+size_t filterBlock(const CompiledPattern& cpattern, LinesBlock const& block,
+                                                        MatchedLines& matched);
+size_t filterBlock(const CompiledPattern& cpattern, CompactLinesBlock const& block,
+                                                        MatchedLines& matched);
+
+// Filter lines from a block and write found lines into the sink if it's not
+// null, 'matched' is used as a temporary storage.
+// Returns number of found lines according pattern
+size_t filterBlock(const CompiledPattern& cpattern, LinesBlock const& block,
+                                        LineSink* sink, MatchedLines& matched);
+size_t filterBlock(const CompiledPattern& cpattern, CompactLinesBlock const& block,
+                                        LineSink* sink, MatchedLines& matched);
+
+// Filter lines from a buffer with the whole content of a file (or its part
+// beginning from a line start) without splitting it into lines beforehand.
+// If the searcher is not null it is used to find the required literal of the
+// pattern and only lines around found literals are matched with the pattern.
+// Lines are split in the same way as MMapReader does.
+// Returns number of found lines according pattern
+size_t filterBuffer(const CompiledPattern& cpattern, const LiteralSearcher* searcher,
+                                                        std::string_view buffer);
 
 /// Inline implementation
 
-inline size_t filterBlock(WildcardMatch& wcmatch,
-                                    const std::string& pattern, LinesBlock const& block) {
+inline size_t filterBlock(const CompiledPattern& cpattern, LinesBlock const& block) {
 
     auto const& lines = block.lines();
     size_t counter = count_if(lines.cbegin(), lines.cend(),
-        [&](auto const& line){ return wcmatch.isMatch(line, pattern); }
+        [&](auto const& line){ return cpattern.isMatch(line); }
     );
 
     return counter;
 }
 
+inline size_t filterBlock(const CompiledPattern& cpattern, LinesBlock const& block,
+                                                        MatchedLines& matched) {
+
+    auto const& lines   = block.lines();
+    auto const& offsets = block.offsets();
+    assert(lines.size() == offsets.size());
+
+    matched.clear();
+    const size_t firstLineNo = block.firstLineNo() + 1;
+    for(size_t i = 0; i < lines.size(); ++i) {
+        if(cpattern.isMatch(lines[i])) {
+            matched.push_back({ lines[i], firstLineNo + i, offsets[i] });
+        }
+    }
+
+    return matched.size();
+}
+
+inline size_t filterBlock(const CompiledPattern& cpattern, LinesBlock const& block,
+                                        LineSink* sink, MatchedLines& matched) {
+
+    if(!sink) {
+        return filterBlock(cpattern, block);
+    }
+
+    auto counter = filterBlock(cpattern, block, matched);
+    if(counter) {
+        sink->write(matched);
+    }
+
+    return counter;
+}
+
+inline size_t filterBlock(const CompiledPattern& cpattern, CompactLinesBlock const& block) {
+
+    size_t counter = 0;
+    block.forEachLine([&](FileLineRef line, std::uint64_t) {
+        counter += cpattern.isMatch(line);
+    });
+
+    return counter;
+}
+
+inline size_t filterBlock(const CompiledPattern& cpattern, CompactLinesBlock const& block,
+                                                        MatchedLines& matched) {
+
+    matched.clear();
+    size_t lineNo = block.firstLineNo() + 1;
+    block.forEachLine([&](FileLineRef line, std::uint64_t offset) {
+        if(cpattern.isMatch(line)) {
+            matched.push_back({ line, lineNo, offset });
+        }
+        ++lineNo;
+    });
+
+    return matched.size();
+}
+
+inline size_t filterBlock(const CompiledPattern& cpattern, CompactLinesBlock const& block,
+                                        LineSink* sink, MatchedLines& matched) {
+
+    if(!sink) {
+        return filterBlock(cpattern, block);
+    }
+
+    auto counter = filterBlock(cpattern, block, matched);
+    if(counter) {
+        sink->write(matched);
+    }
+
+    return counter;
+}
+
 } // namespace proctools
 } // namespace fwc
\ No newline at end of file
@@ -0,0 +1,528 @@
+#include <cstdint>
+#include <algorithm>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "charclass.h"
+#include "lazydfa.h"
+#include "literalsearch.h"
+#include "utils.h"
+#include "regexmatch.h"
+
+namespace fwc {
+
+namespace {
+
+struct RegexNode final {
+    enum class Kind: std::uint8_t {
+        EMPTY,     // matches an empty text
+        BYTES,     // one byte from the set
+        CONCAT,    // children one by one
+        ALTERNATE, // one of children
+        REPEAT     // the child from 'min' to 'max' times
+    };
+
+    constexpr static std::uint32_t INFINITE = UINT32_MAX;
+
+    Kind                   kind { Kind::EMPTY };
+    ByteSet                bytes;
+    std::vector<RegexNode> children;
+    std::uint32_t          min  { 0 };
+    std::uint32_t          max  { 0 };
+};
+
+// alternative of the whole expression with its anchors
+struct RegexBranch final {
+    RegexNode node;
+    bool      anchoredBegin { false };
+    bool      anchoredEnd   { false };
+};
+
+// Recursive descent parser, errors stop the program
+class RegexParser final
+{
+public:
+    RegexParser(std::string_view pattern, bool ignoreCase):
+        _pattern(pattern), _ignoreCase(ignoreCase) {
+    }
+
+    std::vector<RegexBranch> parse();
+
+private:
+    constexpr static std::uint32_t MAX_REPEAT = 1000;
+
+    RegexNode parseAlternation();
+    RegexNode parseConcat(RegexBranch* branch);
+    RegexNode parseRepeat();
+    RegexNode parseAtom();
+    RegexNode parseEscape();
+
+    // '{m}', '{m,}' or '{m,n}' at the position, otherwise '{' is ordinary
+    bool parseBounds(std::uint32_t& min, std::uint32_t& max);
+
+    RegexNode makeByte(unsigned char c) const;
+
+    [[ noreturn ]]
+    void error(const std::string& reason) const {
+        errorAndStop("Invalid regular expression '" + std::string(_pattern) +
+                                                        "': " + reason, false);
+    }
+
+    bool atEnd() const noexcept { return _pos == _pattern.size(); }
+    char peek() const noexcept { return _pattern[_pos]; }
+
+    const std::string_view _pattern;
+    const bool             _ignoreCase;
+    size_t                 _pos { 0 };
+};
+
+std::vector<RegexBranch> RegexParser::parse() {
+
+    std::vector<RegexBranch> branches;
+    while(true) {
+        auto& branch = branches.emplace_back();
+        if(!atEnd() && '^' == peek()) {
+            branch.anchoredBegin = true;
+            ++_pos;
+        }
+        branch.node = parseConcat(&branch);
+
+        if(atEnd()) {
+            break;
+        }
+        if(')' == peek()) {
+            error("unmatched ')'");
+        }
+        ++_pos; // '|'
+    }
+
+    return branches;
+}
+
+RegexNode RegexParser::parseAlternation() {
+
+    RegexNode node;
+    node.kind = RegexNode::Kind::ALTERNATE;
+    while(true) {
+        node.children.push_back(parseConcat(nullptr));
+        if(atEnd() || '|' != peek()) {
+            break;
+        }
+        ++_pos;
+    }
+
+    if(node.children.size() == 1) {
+        return std::move(node.children.front());
+    }
+    return node;
+}
+
+RegexNode RegexParser::parseConcat(RegexBranch* branch) {
+
+    RegexNode node;
+    node.kind = RegexNode::Kind::CONCAT;
+    while(!atEnd() && '|' != peek() && ')' != peek()) {
+        const bool isBranchEnd = _pos + 1 == _pattern.size() || '|' == _pattern[_pos + 1];
+        if('$' == peek() && branch && isBranchEnd) {
+            branch->anchoredEnd = true;
+            ++_pos;
+            break;
+        }
+        node.children.push_back(parseRepeat());
+    }
+
+    if(node.children.empty()) {
+        return {};
+    }
+    if(node.children.size() == 1) {
+        return std::move(node.children.front());
+    }
+    return node;
+}
+
+RegexNode RegexParser::parseRepeat() {
+
+    auto node = parseAtom();
+    while(!atEnd()) {
+        std::uint32_t min = 0;
+        std::uint32_t max = RegexNode::INFINITE;
+        switch(peek()) {
+            case '*':           ++_pos; break;
+            case '+': min = 1;  ++_pos; break;
+            case '?': max = 1;  ++_pos; break;
+            case '{':
+                if(!parseBounds(min, max)) {
+                    return node;
+                }
+                break;
+            default:
+                return node;
+        }
+
+        RegexNode repeat;
+        repeat.kind = RegexNode::Kind::REPEAT;
+        repeat.min  = min;
+        repeat.max  = max;
+        repeat.children.push_back(std::move(node));
+        node = std::move(repeat);
+    }
+
+    return node;
+}
+
+bool RegexParser::parseBounds(std::uint32_t& min, std::uint32_t& max) {
+
+    size_t pos = _pos + 1;
+    auto readNumber = [&](std::uint32_t& value) {
+        const size_t begin = pos;
+        value = 0;
+        while(pos < _pattern.size() && _pattern[pos] >= '0' && _pattern[pos] <= '9') {
+            value = std::min(value * 10 + (_pattern[pos++] - '0'), MAX_REPEAT + 1);
+        }
+        return pos > begin;
+    };
+
+    if(!readNumber(min)) {
+        return false;
+    }
+    max = min;
+    if(pos < _pattern.size() && ',' == _pattern[pos]) {
+        ++pos;
+        if(!readNumber(max)) {
+            max = RegexNode::INFINITE;
+        }
+    }
+    if(pos == _pattern.size() || '}' != _pattern[pos]) {
+        return false;
+    }
+
+    if(min > MAX_REPEAT || (max != RegexNode::INFINITE && max > MAX_REPEAT)) {
+        error("too many repetitions");
+    }
+    if(min > max) {
+        error("invalid repetition bounds");
+    }
+
+    _pos = pos + 1;
+    return true;
+}
+
+RegexNode RegexParser::makeByte(unsigned char c) const {
+
+    RegexNode node;
+    node.kind = RegexNode::Kind::BYTES;
+    node.bytes.set(c);
+    if(_ignoreCase) {
+        addOtherCase(node.bytes);
+    }
+    return node;
+}
+
+RegexNode RegexParser::parseAtom() {
+
+    const char c = _pattern[_pos++];
+    switch(c) {
+        case '(': {
+            auto node = parseAlternation();
+            if(atEnd() || ')' != peek()) {
+                error("missing ')'");
+            }
+            ++_pos;
+            return node;
+        }
+        case '[': {
+            RegexNode node;
+            node.kind = RegexNode::Kind::BYTES;
+            bool invalidElement = false;
+            auto next = parseBracket(_pattern, _pos - 1, false, _ignoreCase,
+                                                    node.bytes, &invalidElement);
+            if(invalidElement) {
+                // fnmatch can't match such a pattern, but it's an error here
+                error("invalid character class");
+            }
+            if(next == std::string_view::npos) {
+                error("missing ']'");
+            }
+            _pos = next;
+            return node;
+        }
+        case '.': {
+            RegexNode node;
+            node.kind = RegexNode::Kind::BYTES;
+            node.bytes.set();
+            return node;
+        }
+        case '\\':
+            return parseEscape();
+        case '*': case '+': case '?':
+            error("nothing to repeat");
+        case '^': case '$':
+            error("anchors are supported only at the ends of alternatives");
+        default:
+            return makeByte(c);
+    }
+}
+
+RegexNode RegexParser::parseEscape() {
+
+    if(atEnd()) {
+        error("trailing '\\'");
+    }
+
+    const char c = _pattern[_pos++];
+    RegexNode node;
+    node.kind = RegexNode::Kind::BYTES;
+    switch(c) {
+        case 'd': case 'D':
+            for(unsigned char b = '0'; b <= '9'; ++b) {
+                node.bytes.set(b);
+            }
+            break;
+        case 'w': case 'W':
+            for(size_t b = 0; b < node.bytes.size(); ++b) {
+                node.bytes[b] = isAsciiLetter(b) || (b >= '0' && b <= '9') || '_' == b;
+            }
+            break;
+        case 's': case 'S':
+            for(unsigned char b: std::string_view(" \t\n\r\f\v")) {
+                node.bytes.set(b);
+            }
+            break;
+        case 't':
+            return makeByte('\t');
+        case 'n':
+            return makeByte('\n');
+        default:
+            return makeByte(c);
+    }
+
+    if(c >= 'A' && c <= 'Z') {
+        node.bytes.flip();
+    }
+    return node;
+}
+
+// Thompson NFA of a node which goes to 'next', it is built backwards
+static std::uint32_t buildNFA(const RegexNode& node, std::uint32_t next, NFA& nfa) {
+
+    using Kind = RegexNode::Kind;
+    switch(node.kind) {
+        case Kind::EMPTY:
+            return next;
+
+        case Kind::BYTES:
+            return nfa.addBytes(node.bytes, next);
+
+        case Kind::CONCAT:
+            for(auto it = node.children.rbegin(); it != node.children.rend(); ++it) {
+                next = buildNFA(*it, next, nfa);
+            }
+            return next;
+
+        case Kind::ALTERNATE: {
+            auto start = buildNFA(node.children.back(), next, nfa);
+            for(size_t i = node.children.size() - 1; i-- > 0; ) {
+                start = nfa.addSplit(buildNFA(node.children[i], next, nfa), start);
+            }
+            return start;
+        }
+
+        case Kind::REPEAT: {
+            auto const& child = node.children.front();
+            std::uint32_t start = next;
+            if(node.max == RegexNode::INFINITE) {
+                // loop: the child again or the next
+                auto split = nfa.addSplit(NFA::NONE, next);
+                nfa.setNext1(split, buildNFA(child, split, nfa));
+                start = split;
+            }
+            else {
+                // optional copies: x{0,2} is (x(x)?)?
+                for(auto i = node.min; i < node.max; ++i) {
+                    start = nfa.addSplit(buildNFA(child, start, nfa), next);
+                }
+            }
+            for(std::uint32_t i = 0; i < node.min; ++i) {
+                start = buildNFA(child, start, nfa);
+            }
+            return start;
+        }
+    }
+
+    return next;
+}
+
+// any bytes and then the state
+static std::uint32_t addAnyLoop(std::uint32_t next, NFA& nfa) {
+
+    auto split = nfa.addSplit(NFA::NONE, next);
+    nfa.setNext1(split, nfa.addBytes(ByteSet().set(), split));
+
+    return split;
+}
+
+// What a node tells about literals of its matches
+struct LiteralInfo final {
+    bool        exact { true }; // the node matches only 'literal'
+    std::string literal;
+    std::string required;       // in all matches
+};
+
+static LiteralInfo analyzeLiterals(const RegexNode& node) {
+
+    // longer literals would be useless for the search
+    constexpr size_t MAX_LITERAL = 256;
+
+    auto longest = [](const std::string& s1, const std::string& s2) -> const std::string& {
+        return s2.size() > s1.size() ? s2 : s1;
+    };
+
+    using Kind = RegexNode::Kind;
+    LiteralInfo info;
+    switch(node.kind) {
+        case Kind::EMPTY:
+            break;
+
+        case Kind::BYTES:
+            if(node.bytes.count() != 1) {
+                info.exact = false;
+                break;
+            }
+            for(size_t c = 0; c < node.bytes.size(); ++c) {
+                if(node.bytes[c]) {
+                    info.literal.push_back(c);
+                }
+            }
+            info.required = info.literal;
+            break;
+
+        case Kind::CONCAT: {
+            std::string run;
+            for(auto const& child: node.children) {
+                auto childInfo = analyzeLiterals(child);
+                if(childInfo.exact && run.size() + childInfo.literal.size() <= MAX_LITERAL) {
+                    run += childInfo.literal;
+                    continue;
+                }
+                info.exact    = false;
+                info.required = longest(longest(info.required, run), childInfo.required);
+                run = childInfo.exact ? childInfo.literal : std::string();
+            }
+            info.required = longest(info.required, run);
+            if(info.exact) {
+                info.literal = run;
+            }
+            break;
+        }
+
+        case Kind::ALTERNATE: {
+            // only a literal of all alternatives is required
+            info = analyzeLiterals(node.children.front());
+            for(size_t i = 1; i < node.children.size(); ++i) {
+                auto childInfo = analyzeLiterals(node.children[i]);
+                info.exact = info.exact && childInfo.exact && childInfo.literal == info.literal;
+                if(childInfo.required != info.required) {
+                    info.required.clear();
+                }
+            }
+            if(!info.exact) {
+                info.literal.clear();
+            }
+            break;
+        }
+
+        case Kind::REPEAT: {
+            auto childInfo = analyzeLiterals(node.children.front());
+            info.exact = false;
+            if(!node.min) {
+                break;
+            }
+            info.required = childInfo.exact ? childInfo.literal : childInfo.required;
+            if(childInfo.exact && node.min == node.max &&
+                                childInfo.literal.size() * node.min <= MAX_LITERAL) {
+                info.exact = true;
+                for(std::uint32_t i = 0; i < node.min; ++i) {
+                    info.literal += childInfo.literal;
+                }
+                info.required = info.literal;
+            }
+            break;
+        }
+    }
+
+    return info;
+}
+
+class RegexCompiledPattern final: public CompiledPattern
+{
+public:
+    RegexCompiledPattern(const std::string& pattern, bool ignoreCase);
+
+    std::string_view requiredLiteral() const override { return _literal; }
+
+private:
+    bool isMatchImpl(const std::string_view& text) const override;
+
+    static NFA makeNFA(const std::vector<RegexBranch>& branches);
+
+    std::string                    _literal;
+    std::optional<LiteralSearcher> _searcher;
+    std::optional<LazyDFA>         _dfa;    // it's empty if the search is enough
+};
+
+// empty texts are passed to isMatchImpl too, like '^$' matches them
+RegexCompiledPattern::RegexCompiledPattern(const std::string& pattern, bool ignoreCase) {
+
+    auto branches = RegexParser(pattern, ignoreCase).parse();
+
+    if(branches.size() == 1) {
+        auto const& branch = branches.front();
+        auto info = analyzeLiterals(branch.node);
+        _literal = info.required;
+        if(!_literal.empty()) {
+            _searcher.emplace(_literal);
+        }
+        if(info.exact && !_literal.empty() && !branch.anchoredBegin && !branch.anchoredEnd) {
+            return;
+        }
+    }
+
+    _dfa.emplace(makeNFA(branches));
+}
+
+NFA RegexCompiledPattern::makeNFA(const std::vector<RegexBranch>& branches) {
+
+    NFA nfa;
+    const auto match   = nfa.addMatch();
+    const auto anyTail = addAnyLoop(match, nfa);
+
+    // unanchored branches are found anywhere in a text
+    std::uint32_t start = NFA::NONE;
+    for(auto it = branches.rbegin(); it != branches.rend(); ++it) {
+        auto branchStart = buildNFA(it->node, it->anchoredEnd ? match : anyTail, nfa);
+        if(!it->anchoredBegin) {
+            branchStart = addAnyLoop(branchStart, nfa);
+        }
+        start = start == NFA::NONE ? branchStart : nfa.addSplit(branchStart, start);
+    }
+    nfa.setStart(start);
+
+    return nfa;
+}
+
+bool RegexCompiledPattern::isMatchImpl(const std::string_view& text) const {
+
+    if(_searcher && !_searcher->contains(text)) {
+        return false;
+    }
+    return !_dfa || _dfa->isMatch(text);
+}
+
+} // anonymous namespace
+
+CompiledPatternPtr RegexMatch::compile(const std::string& pattern) const {
+    return std::make_unique<RegexCompiledPattern>(pattern, _ignoreCase);
+}
+
+} // namespace fwc
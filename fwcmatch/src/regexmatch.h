@@ -0,0 +1,37 @@
+#pragma once
+
+#include "wildcard.h"
+
+namespace fwc {
+
+/*
+Filter by POSIX extended regular expressions (like 'grep -E'): a text is
+matched if the expression is found anywhere in it, '^' and '$' anchor
+alternatives of the whole expression to the beginning and the end.
+Supported: literals, '.', '[...]' (see parseBracket), '\d \w \s' and
+'\D \W \S', '\t', '\n', escapes, groups, '|', '*', '+', '?', '{m}',
+'{m,}' and '{m,n}'. ASCII letters are matched in any case if 'ignoreCase'
+is true. Invalid expressions stop the program with a message.
+
+The expression is parsed into a tree which gives the longest literal
+required by any match. Texts without it are rejected by the SIMD search
+of LiteralSearcher, expressions which are only such a literal are matched
+by this search alone. The rest are compiled into a Thompson NFA and matched
+by LazyDFA, so matching is linear time without backtracking.
+Thread safe
+*/
+class RegexMatch final: public WildcardMatch
+{
+public:
+    explicit RegexMatch(bool ignoreCase = false) noexcept:
+        _ignoreCase(ignoreCase) {
+    }
+
+    [[nodiscard]]
+    CompiledPatternPtr compile(const std::string& pattern) const override;
+
+private:
+    const bool _ignoreCase;
+};
+
+} // namespace fwc
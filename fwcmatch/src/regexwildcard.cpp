@@ -1,16 +1,14 @@
-
-#include <regex>
 #include <string_view>
 #include <vector>
 #include <utility>
 
+#include "regexmatch.h"
 #include "regexwildcard.h"
 
 namespace fwc {
 
 using string      = std::string;
 using string_view = std::string_view;
-using regex       = std::regex;
 
 static const std::vector<std::pair<string, string>> RE_REPLACE = {
 
@@ -22,7 +20,7 @@ static const std::vector<std::pair<string, string>> RE_REPLACE = {
     { "(", "\\(" },
     { ")", "\\)" },
     { "{", "\\{" },
-    { "{", "\\}" },
+    { "}", "\\}" },
     { "[", "\\[" },
     { "]", "\\]" },
     { "+", "\\+" },
@@ -32,9 +30,6 @@ static const std::vector<std::pair<string, string>> RE_REPLACE = {
     { "?", "." },
 };
 
-thread_local string REMatch::_pattern;
-thread_local regex REMatch::_regex;
-
 static void replaceAll(string& str, const string& from, const string& to) {
     string::size_type pos = 0;
     while ( (pos = str.find(from, pos) ) != string::npos ) {
@@ -43,27 +38,44 @@ static void replaceAll(string& str, const string& from, const string& to) {
     }
 }
 
-bool REMatch::isMatchImpl(const string_view& text, const string& pattern) const {
+namespace {
 
-    mkRegExPattern(pattern);
-    return regex_match(text.cbegin(), text.cend(), _regex);
-}
+class RECompiledPattern final: public CompiledPattern
+{
+public:
+    explicit RECompiledPattern(const string& pattern);
 
-void REMatch::mkRegExPattern(const string& pattern) {
-    if(pattern == _pattern) {
-        return;
+    string_view requiredLiteral() const override {
+        return _cpattern->requiredLiteral();
     }
 
-    string repattern = _pattern = pattern;
+private:
+    bool isMatchImpl(const string_view& text) const override;
+
+    CompiledPatternPtr _cpattern;
+};
+
+RECompiledPattern::RECompiledPattern(const string& pattern):
+    CompiledPattern(pattern) {
+
+    string repattern = pattern;
     for(auto const& line: RE_REPLACE) {
         auto const& [from, to] = line;
         replaceAll(repattern, from, to);
     }
 
-    //constexpr regex::flag_type flags = regex::optimize|regex::basic;
-    //constexpr regex::flag_type flags = regex::optimize|regex::ECMAScript;
-    constexpr regex::flag_type flags = regex::ECMAScript;
-    _regex.assign(repattern, flags);
+    // the whole text must be matched
+    _cpattern = RegexMatch().compile("^" + repattern + "$");
+}
+
+bool RECompiledPattern::isMatchImpl(const string_view& text) const {
+    return _cpattern->isMatch(text);
+}
+
+} // anonymous namespace
+
+CompiledPatternPtr REMatch::compile(const string& pattern) const {
+    return std::make_unique<RECompiledPattern>(pattern);
 }
 
-} // namespace fwc
\ No newline at end of file
+} // namespace fwc
@@ -1,22 +1,16 @@
 #pragma once
 
-#include <regex>
-
 #include "wildcard.h"
 
 namespace fwc {
 
+// Wildcards are converted into a regular expression for RegexMatch
+// Thread safe
 class REMatch final: public WildcardMatch
 {
-private:
-    bool isMatchImpl(const std::string_view& text,
-                                const std::string& pattern) const override;
-
-    static void mkRegExPattern(const std::string& pattern);
-
-    // used as a simple thread safe cache
-    thread_local static std::string _pattern;
-    thread_local static std::regex  _regex;
+public:
+    [[nodiscard]]
+    CompiledPatternPtr compile(const std::string& pattern) const override;
 };
 
-} // namespace fwc
\ No newline at end of file
+} // namespace fwc
@@ -0,0 +1,98 @@
+#include <cassert>
+#include <cstring>
+
+#include "reorderbuffer.h"
+
+namespace fwc {
+
+ReorderBuffer::ReorderBuffer(size_t windowSize):
+    _slots(windowSize) {
+
+    assert(windowSize > 0);
+}
+
+void ReorderBuffer::reset(LineSink* sink, bool copyLines) {
+
+    assert(!_emitting);
+    for(auto& slot: _slots) {
+        slot.ready = false;
+    }
+
+    _sink = sink;
+    _copyLines = copyLines;
+    _nextSeqNo = 0;
+}
+
+void ReorderBuffer::waitForSlot(size_t seqNo) {
+
+    std::unique_lock lock(_mutex);
+    _cvSlotFree.wait(lock, [&](){ return seqNo < _nextSeqNo + _slots.size(); });
+}
+
+void ReorderBuffer::copyToSlot(Slot& slot, const MatchedLines& lines) {
+
+    slot.lines = lines;
+    if(!_copyLines || lines.empty()) {
+        return;
+    }
+
+    size_t dataSize = 0;
+    for(auto const& mline: lines) {
+        dataSize += mline.line.size();
+    }
+
+    // memory is not released so it grows to the biggest block only
+    if(slot.data.size() < dataSize) {
+        slot.data.resize(dataSize);
+    }
+
+    char* data = slot.data.data();
+    for(auto& mline: slot.lines) {
+        const auto size = mline.line.size();
+        std::memcpy(data, mline.line.data(), size);
+        mline.line = FileLineRef(data, size);
+        data += size;
+    }
+}
+
+void ReorderBuffer::put(size_t seqNo, const MatchedLines& lines) {
+
+    const size_t windowSize = _slots.size();
+    auto& slot = _slots[seqNo % windowSize];
+
+    // the slot belongs only to this block while it isn't ready,
+    // the producer guarantees it with 'waitForSlot'
+    copyToSlot(slot, lines);
+
+    std::unique_lock lock(_mutex);
+    assert(seqNo >= _nextSeqNo && seqNo < _nextSeqNo + windowSize);
+    assert(!slot.ready);
+    slot.ready = true;
+
+    if(_emitting) {
+        // another thread writes lines and it will take this block too
+        return;
+    }
+
+    _emitting = true;
+    for(;;) {
+        auto& head = _slots[_nextSeqNo % windowSize];
+        if(!head.ready) {
+            break;
+        }
+
+        // nobody changes the head slot until _nextSeqNo is increased
+        lock.unlock();
+        if(_sink && !head.lines.empty()) {
+            _sink->write(head.lines);
+        }
+        lock.lock();
+
+        head.ready = false;
+        ++_nextSeqNo;
+        _cvSlotFree.notify_one();
+    }
+    _emitting = false;
+}
+
+} // namespace fwc
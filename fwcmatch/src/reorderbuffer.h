@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#include "noncopyable.h"
+#include "linesink.h"
+
+namespace fwc {
+
+/*
+Reorder stage for found lines. Blocks are numbered by a producer, consumers
+finish them in any order and put their found lines here. Lines are given to
+the sink strictly in the order of block numbers.
+
+Memory is bounded with a window of slots: a block with a number N can be put
+only when all blocks with numbers less than N - windowSize have been emitted,
+so the producer must call 'waitForSlot' before it reads a new block.
+The thread which completes the oldest pending block writes all ready blocks
+into the sink, other threads don't wait for it.
+*/
+
+class ReorderBuffer final: private noncopyable
+{
+public:
+
+    explicit ReorderBuffer(size_t windowSize);
+
+    // it must be called before processing, 'copyLines' means that lines
+    // refer to memory of blocks which can be reused after 'put'
+    void reset(LineSink* sink, bool copyLines);
+
+    // it is called in producer thread, it blocks until there is a free slot
+    // for the block with this number
+    void waitForSlot(size_t seqNo);
+
+    // it is called in consumer threads for each block, even without found lines
+    void put(size_t seqNo, const MatchedLines& lines);
+
+    // number of the next block which is expected to be emitted
+    [[nodiscard]]
+    size_t nextSeqNo() const noexcept { return _nextSeqNo; }
+
+    [[nodiscard]]
+    size_t windowSize() const noexcept { return _slots.size(); }
+
+private:
+
+    struct Slot
+    {
+        MatchedLines      lines;
+        std::vector<char> data;
+        bool              ready { false };
+    };
+
+    void copyToSlot(Slot& slot, const MatchedLines& lines);
+
+    std::vector<Slot>       _slots;
+    std::mutex              _mutex;
+    std::condition_variable _cvSlotFree;
+    LineSink*               _sink { nullptr };
+    size_t                  _nextSeqNo { 0 };
+    bool                    _copyLines { true };
+    bool                    _emitting { false };
+};
+
+} // namespace fwc
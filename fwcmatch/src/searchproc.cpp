@@ -0,0 +1,23 @@
+#include <optional>
+
+#include "literalsearch.h"
+#include "proctools.h"
+#include "searchproc.h"
+
+namespace fwc {
+
+size_t SearchFirstProcessor::execute(MMapReader& freader, const std::string& filename,
+                                                    const CompiledPattern& cpattern) {
+
+    std::optional<LiteralSearcher> searcher;
+    if(auto literal = cpattern.requiredLiteral(); !literal.empty()) {
+        searcher.emplace(literal);
+    }
+
+    ScopedFileOpener fopener(freader, filename);
+
+    return proctools::filterBuffer(cpattern,
+                        searcher ? &*searcher : nullptr, freader.data());
+}
+
+} // namespace fwc
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "noncopyable.h"
+#include "mmapreader.h"
+#include "wildcard.h"
+
+namespace fwc {
+
+/*
+This class implements "search-first" way like grep does: instead of splitting
+all lines in a file and matching each of them it searches for the required
+literal of the pattern in the whole mapped file and looks for line
+boundaries only around found literals. Each such a line is matched with
+the full pattern. It's much faster than other ways when only a small
+share of lines are matched.
+It works only with MMapReader because the whole file must be in memory.
+*/
+
+class SearchFirstProcessor final: private noncopyable
+{
+public:
+
+    size_t execute(MMapReader& freader, const std::string& filename,
+                    const CompiledPattern& cpattern);
+
+    size_t execute(MMapReader& freader, const std::string& filename,
+                    const WildcardMatch& wcmatch, const std::string& pattern) {
+        return execute(freader, filename, *wcmatch.compile(pattern));
+    }
+};
+
+} // namespace fwc
@@ -11,14 +11,15 @@ namespace fwc {
 
 static constexpr size_t BLOCK_SIZE = 4*1024;
 
-SequentialProcessor::SequentialProcessor(size_t maxLines, bool needsBuffer) {
+SequentialProcessor::SequentialProcessor(BlockLimits limits, bool needsBuffer) {
 
-    assert(maxLines > 0);
-    _linesBlock.alloc(maxLines, needsBuffer, BLOCK_SIZE);
+    assert(limits.maxLines > 0);
+    _linesBlock.alloc(limits, needsBuffer, BLOCK_SIZE);
+    _matched.reserve(limits.maxLines);
 }
 
 size_t SequentialProcessor::execute(FileReader& freader, const std::string& filename,
-                            WildcardMatch& wcmatch, const std::string& pattern) {
+                                const CompiledPattern& cpattern, LineSink* sink) {
 
     ScopedFileOpener fopener(freader, filename);
 
@@ -30,7 +31,7 @@ size_t SequentialProcessor::execute(FileReader& freader, const std::string& file
             break;
         }
 
-        result += proctools::filterBlock(wcmatch, pattern, _linesBlock);
+        result += proctools::filterBlock(cpattern, _linesBlock, sink, _matched);
     }
 
     return result;
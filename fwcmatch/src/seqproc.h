@@ -8,6 +8,7 @@
 #include "linesblock.h"
 #include "wildcard.h"
 #include "filereader.h"
+#include "linesink.h"
 
 namespace fwc {
 
@@ -15,14 +16,22 @@ class SequentialProcessor final: private noncopyable
 {
 public:
 
-    SequentialProcessor(size_t maxLines, bool needsBuffer);
+    SequentialProcessor(BlockLimits limits, bool needsBuffer);
 
+    // if the sink is not null found lines are written into it
     size_t execute(FileReader& freader, const std::string& filename,
-                    WildcardMatch& wcmatch, const std::string& pattern);
+                    const CompiledPattern& cpattern, LineSink* sink = nullptr);
+
+    size_t execute(FileReader& freader, const std::string& filename,
+                    const WildcardMatch& wcmatch, const std::string& pattern,
+                    LineSink* sink = nullptr) {
+        return execute(freader, filename, *wcmatch.compile(pattern), sink);
+    }
 
 private:
 
     LinesBlock   _linesBlock;
+    MatchedLines _matched;
 };
 
 } // namespace fwc
\ No newline at end of file
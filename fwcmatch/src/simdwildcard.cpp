@@ -0,0 +1,61 @@
+#include "literalsearch.h"
+#include "mywildcard.h"
+#include "simdwildcard.h"
+
+namespace fwc {
+
+namespace {
+
+class SIMDCompiledPattern final: public CompiledPattern
+{
+public:
+    SIMDCompiledPattern(const std::string& pattern, CompiledPatternPtr&& cpattern,
+                                                                bool ignoreCase):
+        CompiledPattern(pattern),
+        _cpattern(std::move(cpattern)),
+        _searcher(_cpattern->requiredLiteral()),
+        _literalOnly(!ignoreCase && isLiteralOnly(pattern)) {
+    }
+
+    std::string_view requiredLiteral() const override {
+        return _cpattern->requiredLiteral();
+    }
+
+private:
+    bool isMatchImpl(const std::string_view& text) const override {
+        if(!_searcher.contains(text)) {
+            return false;
+        }
+        return _literalOnly || _cpattern->isMatch(text);
+    }
+
+    // check if pattern looks like '*literal*'
+    static bool isLiteralOnly(std::string_view pattern) {
+        auto begin = pattern.find_first_not_of('*');
+        auto end = pattern.find_last_not_of('*');
+        if(begin == std::string_view::npos || begin == 0 || end == pattern.size() - 1) {
+            return false;
+        }
+        return pattern.substr(begin, end - begin + 1).find_first_of("*?[\\") ==
+                                                        std::string_view::npos;
+    }
+
+    const CompiledPatternPtr _cpattern;
+    const LiteralSearcher    _searcher;
+    const bool               _literalOnly;
+};
+
+} // anonymous namespace
+
+CompiledPatternPtr SIMDWildcardMatch::compile(const std::string& pattern) const {
+
+    auto cpattern = MyWildcardMatch(_ignoreCase).compile(pattern);
+    if(cpattern->requiredLiteral().empty()) {
+        // nothing to search
+        return cpattern;
+    }
+
+    return std::make_unique<SIMDCompiledPattern>(pattern, std::move(cpattern), _ignoreCase);
+}
+
+} // namespace fwc
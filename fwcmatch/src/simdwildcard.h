@@ -0,0 +1,26 @@
+#pragma once
+
+#include "wildcard.h"
+
+namespace fwc {
+
+// MyWildcardMatch with SIMD search of the required literal of the pattern
+// in front of it. Patterns like '*literal*' are matched only by this search.
+// For case insensitive matching the literal has no letters (see
+// MyWildcardMatch), so the search is still exact.
+// Thread safe
+class SIMDWildcardMatch final: public WildcardMatch
+{
+public:
+    explicit SIMDWildcardMatch(bool ignoreCase = false) noexcept:
+        _ignoreCase(ignoreCase) {
+    }
+
+    [[nodiscard]]
+    CompiledPatternPtr compile(const std::string& pattern) const override;
+
+private:
+    const bool _ignoreCase;
+};
+
+} // namespace fwc
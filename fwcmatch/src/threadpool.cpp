@@ -0,0 +1,86 @@
+#include "utils.h"
+#include "threadpool.h"
+
+namespace fwc {
+
+ThreadPool::ThreadPool(size_t numOfThreads) {
+
+    _threads.reserve(numOfThreads);
+    for(size_t i = 0; i < numOfThreads; ++i) {
+        _threads.emplace_back(&ThreadPool::workerFunc, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+
+    {
+        std::scoped_lock lock(_mutex);
+        _stop = true;
+        _cvJob.notify_all();
+    }
+
+    for(auto& t: _threads) {
+        t.join();
+    }
+}
+
+void ThreadPool::runImpl(size_t numOfTasks, void* func, TaskFunc taskFunc) {
+
+    if(numOfTasks > size()) {
+        // tasks without threads would never be done and 'wait' would hang
+        errorAndStop("Thread pool is too small for the tasks", false);
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    if(_pending) {
+        _cvDone.wait(lock, [&](){ return 0 == _pending; });
+    }
+
+    _func       = func;
+    _taskFunc   = taskFunc;
+    _numOfTasks = numOfTasks;
+    _pending    = numOfTasks;
+    ++_jobId;
+    _cvJob.notify_all();
+}
+
+void ThreadPool::wait() {
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    if(_pending) {
+        _cvDone.wait(lock, [&](){ return 0 == _pending; });
+    }
+}
+
+void ThreadPool::workerFunc(size_t idx) {
+
+    std::uint64_t lastJobId = 0;
+
+    for(;;) {
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cvJob.wait(lock, [&](){ return _stop || lastJobId != _jobId; });
+        if(_stop) {
+            break;
+        }
+
+        lastJobId = _jobId;
+        if(idx >= _numOfTasks) {
+            // this worker is not needed in this job
+            continue;
+        }
+
+        auto func = _func;
+        auto taskFunc = _taskFunc;
+        lock.unlock();
+
+        taskFunc(func, idx);
+
+        lock.lock();
+        if(0 == --_pending) {
+            _cvDone.notify_all();
+        }
+    }
+}
+
+} // namespace fwc
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "noncopyable.h"
+
+namespace fwc {
+
+/*
+Fixed set of worker threads which are created once and park on a condition
+variable between jobs. A job is one callable which is called as func(idx)
+in the worker with index idx for each idx in [0, numOfTasks).
+It is enough for processors where each thread runs its own loop until
+the end of a file and it needs no memory allocation for a job.
+Only one job can be run at the same time, run() waits for the previous job.
+*/
+class ThreadPool final: private noncopyable
+{
+public:
+
+    explicit ThreadPool(size_t numOfThreads);
+    ~ThreadPool();
+
+    [[nodiscard]]
+    size_t size() const noexcept { return _threads.size(); }
+
+    // Start a job, it does not wait for the job to finish.
+    // The callable must live until wait() returns.
+    template<typename Callable>
+    void run(size_t numOfTasks, Callable& func) {
+        runImpl(numOfTasks, &func, [](void* f, size_t idx) {
+            (*static_cast<Callable*>(f))(idx);
+        });
+    }
+
+    // Wait for the current job to finish
+    void wait();
+
+private:
+
+    using TaskFunc = void (*)(void*, size_t);
+
+    void runImpl(size_t numOfTasks, void* func, TaskFunc taskFunc);
+    void workerFunc(size_t idx);
+
+    std::vector<std::thread> _threads;
+    std::mutex               _mutex;
+    std::condition_variable  _cvJob;
+    std::condition_variable  _cvDone;
+    void*                    _func       { nullptr };
+    TaskFunc                 _taskFunc   { nullptr };
+    size_t                   _numOfTasks { 0 };
+    size_t                   _pending    { 0 };
+    std::uint64_t            _jobId      { 0 };
+    bool                     _stop       { false };
+};
+
+} // namespace fwc
@@ -0,0 +1,416 @@
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "utils.h"
+#include "uringreader.h"
+
+namespace fwc {
+
+static int uringSetup(unsigned entries, struct io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int uringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete,
+                                        flags, nullptr, 0));
+}
+
+UringReader::UringReader(size_t bufferSize, size_t queueDepth):
+    _buffers(queueDepth) {
+
+    assert(bufferSize > 0);
+    assert(queueDepth > 0);
+
+    for(auto& buffer: _buffers) {
+        buffer.data.resize(bufferSize);
+    }
+
+    // synchronous reading is used if it fails
+    setupRing(static_cast<unsigned>(queueDepth));
+}
+
+UringReader::~UringReader() {
+    close();
+    releaseRing();
+}
+
+bool UringReader::setupRing(unsigned entries) {
+
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+
+    _ringFd = uringSetup(entries, &params);
+    if(_ringFd < 0) {
+        _ringFd = -1;
+        return false;
+    }
+
+    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    const bool singleMMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(singleMMap) {
+        _sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+    }
+
+    _sqRing = ::mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING);
+    if(MAP_FAILED == _sqRing) {
+        _sqRing = nullptr;
+        releaseRing();
+        return false;
+    }
+
+    if(singleMMap) {
+        _cqRing = _sqRing;
+    }
+    else {
+        _cqRing = ::mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_CQ_RING);
+        if(MAP_FAILED == _cqRing) {
+            _cqRing = nullptr;
+            releaseRing();
+            return false;
+        }
+    }
+
+    _sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = ::mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES);
+    if(MAP_FAILED == sqes) {
+        releaseRing();
+        return false;
+    }
+    _sqes = static_cast<struct io_uring_sqe*>(sqes);
+
+    auto* sq = static_cast<char*>(_sqRing);
+    _sqHead  = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    _sqTail  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    _sqMask  = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    _sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    auto* cq = static_cast<char*>(_cqRing);
+    _cqHead  = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    _cqTail  = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    _cqMask  = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    _cqes    = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    return true;
+}
+
+void UringReader::releaseRing() {
+
+    if(_sqes) {
+        ::munmap(_sqes, _sqesSize);
+        _sqes = nullptr;
+    }
+
+    if(_cqRing && _cqRing != _sqRing) {
+        ::munmap(_cqRing, _cqRingSize);
+    }
+    _cqRing = nullptr;
+
+    if(_sqRing) {
+        ::munmap(_sqRing, _sqRingSize);
+        _sqRing = nullptr;
+    }
+
+    if(_ringFd >= 0) {
+        ::close(_ringFd);
+        _ringFd = -1;
+    }
+}
+
+// open file
+void UringReader::open(const std::string& filename) {
+    if(filename.empty()) {
+        errorAndStop("File name is empty", false);
+    }
+
+    if(_file >= 0) {
+        // file is open
+        return;
+    }
+
+    _file = ::open(filename.c_str(), O_RDONLY);
+    if(-1 == _file) {
+        errorAndStop("File opening failed");
+    }
+
+    struct stat sb;
+    if (::fstat(_file, &sb) == -1) {
+        errorAndStop("fstat");
+    }
+    _fileSize = sb.st_size;
+
+    ::posix_fadvise(_file, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    resetPosition();
+    startReading(0);
+}
+
+// close file
+void UringReader::close() {
+
+    if(_file >= 0) {
+        // the kernel must not write into buffers after this
+        cancelReads();
+        ::close(_file);
+        _file = -1;
+    }
+
+    _pos = _end = nullptr;
+}
+
+void UringReader::submitRead(size_t idx) {
+
+    auto& buffer = _buffers[idx];
+    assert(!buffer.pending);
+
+    buffer.size = std::min(buffer.data.size(), _fileSize - std::min(_readOffset, _fileSize));
+    buffer.result = 0;
+    if(!buffer.size) {
+        // nothing to read
+        return;
+    }
+
+    buffer.offset = _readOffset;
+    _readOffset += buffer.size;
+
+    if(!usesUring()) {
+        buffer.result = ::pread(_file, buffer.data.data(), buffer.size, buffer.offset);
+        if(buffer.result < 0) {
+            errorAndStop("pread");
+        }
+        return;
+    }
+
+    const unsigned tail = *_sqTail;
+    const unsigned index = tail & *_sqMask;
+
+    auto* sqe = &_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = IORING_OP_READ;
+    sqe->fd        = _file;
+    sqe->addr      = reinterpret_cast<std::uint64_t>(buffer.data.data());
+    sqe->len       = static_cast<std::uint32_t>(buffer.size);
+    sqe->off       = buffer.offset;
+    sqe->user_data = idx;
+
+    _sqArray[index] = index;
+    __atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    buffer.pending = true;
+}
+
+void UringReader::submit(unsigned count) {
+
+    while(count > 0) {
+        int res = uringEnter(_ringFd, count, 0, 0);
+        if(res < 0) {
+            if(errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            errorAndStop("io_uring_enter");
+        }
+        count -= std::min(count, static_cast<unsigned>(res));
+    }
+}
+
+void UringReader::reapCompletions() {
+
+    unsigned head = *_cqHead;
+    const unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+
+    for(; head != tail; ++head) {
+        auto const& cqe = _cqes[head & *_cqMask];
+        auto& buffer = _buffers[cqe.user_data];
+        buffer.result = cqe.res;
+        buffer.pending = false;
+    }
+
+    __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+}
+
+void UringReader::waitFor(size_t idx) {
+
+    auto& buffer = _buffers[idx];
+    while(buffer.pending) {
+        reapCompletions();
+        if(!buffer.pending) {
+            break;
+        }
+
+        if(uringEnter(_ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+            errorAndStop("io_uring_enter");
+        }
+    }
+}
+
+void UringReader::cancelReads() {
+
+    // reads are short, so it's simpler to wait for them than to cancel
+    for(size_t i = 0; i < _buffers.size(); ++i) {
+        waitFor(i);
+    }
+}
+
+void UringReader::startReading(size_t offset) {
+
+    cancelReads();
+
+    _readOffset = offset;
+    _pos = _end = nullptr;
+
+    unsigned count = 0;
+    for(size_t i = 0; i < _buffers.size(); ++i) {
+        submitRead(i);
+        count += _buffers[i].pending;
+    }
+
+    if(count) {
+        submit(count);
+    }
+
+    // the first buffer is the current one but it is not taken yet
+    _current = _buffers.size() - 1;
+    _started = false;
+}
+
+bool UringReader::nextBuffer() {
+
+    if(_started) {
+        // all lines of the current buffer are taken, so it can be reused
+        submitRead(_current);
+        if(_buffers[_current].pending) {
+            submit(1);
+        }
+    }
+    _started = true;
+    _current = (_current + 1) % _buffers.size();
+
+    waitFor(_current);
+
+    auto& buffer = _buffers[_current];
+    if(!buffer.size) {
+        // end of file
+        _pos = _end = nullptr;
+        return false;
+    }
+
+    if(buffer.result == -EINVAL || buffer.result == -EOPNOTSUPP) {
+        // IORING_OP_READ isn't supported by the kernel
+        buffer.result = 0;
+    }
+    else if(buffer.result < 0) {
+        errno = static_cast<int>(-buffer.result);
+        errorAndStop("Reading with io_uring failed");
+    }
+
+    // a short read is possible, the rest is read synchronously
+    while(static_cast<size_t>(buffer.result) < buffer.size) {
+        auto res = ::pread(_file, buffer.data.data() + buffer.result,
+                            buffer.size - buffer.result, buffer.offset + buffer.result);
+        if(res < 0) {
+            errorAndStop("pread");
+        }
+        if(!res) {
+            // file is truncated
+            break;
+        }
+        buffer.result += res;
+    }
+
+    _pos = buffer.data.data();
+    _end = _pos + buffer.result;
+    return _pos != _end;
+}
+
+// read next line in file
+FileLineRef UringReader::readLine() {
+
+    // It is experimental code and so I don't do correct error handling for all cases
+    assert(_file >= 0);
+    assert(_buffer && _bufferSize > 1);
+
+    size_t consumed = 0;
+    bool newline = false;
+    startLine();
+
+    for(;;) {
+        if(_pos == _end && !nextBuffer()) {
+            // end of file, may be with the last line without newline
+            if(!consumed) {
+                return {};
+            }
+            break;
+        }
+
+        const char* eol = static_cast<const char*>(std::memchr(_pos, '\n', _end - _pos));
+        const size_t partSize = (eol ? eol : _end) - _pos;
+        const size_t copySize = appendToLine(_pos, partSize);
+        consumed += copySize;
+        _pos += copySize;
+
+        if(copySize < partSize) {
+            // line is longer than the buffer and there is no overflow arena,
+            // the rest is the next line
+            break;
+        }
+
+        if(eol) {
+            // skip newline symbol, it is stripped by takeLine
+            ++_pos;
+            ++consumed;
+            newline = true;
+            break;
+        }
+    }
+
+    advancePosition(consumed);
+    return takeLine(newline);
+}
+
+bool UringReader::seek(size_t offset) {
+
+    assert(_file >= 0);
+
+    if(!offset) {
+        startReading(0);
+        resetPosition();
+        return true;
+    }
+
+    // skip the rest of the line (or only newline before the offset)
+    startReading(offset - 1);
+    size_t pos = offset - 1;
+    for(;;) {
+        if(_pos == _end && !nextBuffer()) {
+            break;
+        }
+
+        const char* eol = static_cast<const char*>(std::memchr(_pos, '\n', _end - _pos));
+        if(eol) {
+            pos += eol + 1 - _pos;
+            _pos = eol + 1;
+            break;
+        }
+
+        pos += _end - _pos;
+        _pos = _end;
+    }
+
+    resetPosition(pos);
+    return true;
+}
+
+} // namespace fwc
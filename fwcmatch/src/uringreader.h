@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <sys/types.h>
+
+#include "filereader.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace fwc {
+
+/*
+Reader which keeps several big reads of a file in flight with io_uring
+(raw system calls, liburing is not required). The file is read into a ring
+of preallocated buffers, lines are split out of the oldest completed buffer
+while next buffers are still being read, so I/O and matching overlap.
+A buffer is submitted again as soon as all its lines are taken.
+Lines are copied into the line buffer because a ring buffer is reused
+while blocks with lines can still be processed by other threads.
+If io_uring is not available (old kernel, seccomp) buffers are filled with
+synchronous pread calls.
+*/
+
+class UringReader final: public FileReader
+{
+public:
+
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 1024*1024;
+    static constexpr size_t DEFAULT_QUEUE_DEPTH = 4;
+
+    explicit UringReader(size_t bufferSize = DEFAULT_BUFFER_SIZE,
+                            size_t queueDepth = DEFAULT_QUEUE_DEPTH);
+    ~UringReader();
+
+    // open file
+    void open(const std::string& filename) override;
+
+    // close file
+    void close() override;
+
+    bool needsBuffer() const override { return true; } ;
+
+    // read next line in file
+    // FileLineRef is used to avoid copying
+    FileLineRef readLine() override;
+
+    bool seek(size_t offset) override;
+    bool canSeek() const override { return true; }
+
+    // false if synchronous reading is used
+    [[nodiscard]]
+    bool usesUring() const noexcept { return _ringFd >= 0; }
+
+private:
+
+    struct Buffer
+    {
+        std::vector<char> data;
+        size_t            offset  { 0 }; // offset in file
+        size_t            size    { 0 }; // number of requested bytes
+        ssize_t           result  { 0 }; // number of read bytes or -errno
+        bool              pending { false };
+    };
+
+    bool setupRing(unsigned entries);
+    void releaseRing();
+
+    // submit reading of the next part of the file into the buffer
+    void submitRead(size_t idx);
+    void submit(unsigned count);
+    void waitFor(size_t idx);
+    void reapCompletions();
+    void cancelReads();
+
+    // start reading from the offset with all buffers
+    void startReading(size_t offset);
+
+    // make the next buffer current, returns false at the end of file
+    bool nextBuffer();
+
+    std::vector<Buffer> _buffers;
+    size_t      _current    { 0 };
+    const char* _pos        { nullptr };
+    const char* _end        { nullptr };
+    size_t      _readOffset { 0 };
+    size_t      _fileSize   { 0 };
+    int         _file       { -1 };
+    bool        _started    { false };
+
+    // io_uring
+    int            _ringFd   { -1 };
+    void*          _sqRing   { nullptr };
+    void*          _cqRing   { nullptr };
+    size_t         _sqRingSize { 0 };
+    size_t         _cqRingSize { 0 };
+    io_uring_sqe*  _sqes     { nullptr };
+    size_t         _sqesSize { 0 };
+    unsigned*      _sqHead   { nullptr };
+    unsigned*      _sqTail   { nullptr };
+    unsigned*      _sqMask   { nullptr };
+    unsigned*      _sqArray  { nullptr };
+    unsigned*      _cqHead   { nullptr };
+    unsigned*      _cqTail   { nullptr };
+    unsigned*      _cqMask   { nullptr };
+    io_uring_cqe*  _cqes     { nullptr };
+};
+
+} // namespace fwc
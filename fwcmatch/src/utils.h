@@ -7,6 +7,9 @@
 
 namespace fwc {
 
+// It's used to avoid false sharing between threads
+constexpr size_t CACHE_LINE_SIZE = 64;
+
 [[ noreturn ]]
 inline void errorAndStop(const std::string& msg, bool useErrno = true) {
     if(useErrno) {
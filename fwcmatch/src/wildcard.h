@@ -1,31 +1,72 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <string_view>
 
+#include "noncopyable.h"
+
 namespace fwc {
 
-class WildcardMatch
+// Wildcard pattern analysed once and ready to be matched with any number of texts.
+// It is immutable after creation so one object can be shared between threads.
+class CompiledPattern: private noncopyable
 {
 public:
-    virtual ~WildcardMatch() {};
+    virtual ~CompiledPattern() {};
 
-    bool isMatch(const std::string_view& text, const std::string& pattern) const {
-        if(pattern.empty()) {
+    bool isMatch(const std::string_view& text) const {
+        if(_matchesAll) {
             // regard empty pattern as "*", linux grep conducts in the same way
             return true;
         }
 
-        if(text.empty()) {
+        if(text.empty() && !_checksEmpty) {
             // only * in pattern can match an empty text
-            return (pattern.size() == 1 && pattern[0] == '*');
+            return _matchesEmpty;
         }
 
-        return isMatchImpl(text, pattern);
+        return isMatchImpl(text);
+    }
+
+    // Literal which must be in any matched text, it can be used for fast
+    // prefiltering. Empty value means there is no such a literal.
+    [[nodiscard]]
+    virtual std::string_view requiredLiteral() const { return {}; }
+
+protected:
+    explicit CompiledPattern(const std::string& pattern):
+        _matchesAll(pattern.empty()),
+        _matchesEmpty(pattern.size() == 1 && pattern[0] == '*') {
+    }
+
+    // all texts (empty ones too) are passed to isMatchImpl, it's for
+    // patterns which are not made from one wildcard
+    CompiledPattern() noexcept:
+        _matchesAll(false),
+        _matchesEmpty(false),
+        _checksEmpty(true) {
     }
 
 private:
-    virtual bool isMatchImpl(const std::string_view& text, const std::string& pattern) const = 0;
+    virtual bool isMatchImpl(const std::string_view& text) const = 0;
+
+    const bool _matchesAll;
+    const bool _matchesEmpty;
+    const bool _checksEmpty { false };
+};
+
+using CompiledPatternPtr = std::unique_ptr<const CompiledPattern>;
+
+class WildcardMatch
+{
+public:
+    virtual ~WildcardMatch() {};
+
+    // Analyse the pattern. It is supposed to be called once before
+    // reading and filtering, not for each line.
+    [[nodiscard]]
+    virtual CompiledPatternPtr compile(const std::string& pattern) const = 0;
 };
 
-} // namespace fwc
\ No newline at end of file
+} // namespace fwc
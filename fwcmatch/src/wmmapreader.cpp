@@ -0,0 +1,218 @@
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "utils.h"
+#include "wmmapreader.h"
+
+namespace fwc {
+
+// Pages are advised by such steps, read ahead is two steps.
+static constexpr size_t ADVICE_STEP = 16*1024*1024;
+
+static size_t alignDown(size_t value, size_t alignment) {
+    return value - value % alignment;
+}
+
+WMMapReader::WMMapReader(size_t windowSize, bool dropCache):
+    _pageSize(::sysconf(_SC_PAGESIZE)),
+    _windowSize(std::max(alignDown(windowSize, _pageSize), _pageSize)),
+    _dropCache(dropCache) {
+}
+
+WMMapReader::~WMMapReader() {
+    close();
+}
+
+// open file
+void WMMapReader::open(const std::string& filename) {
+    if(filename.empty()) {
+        errorAndStop("File name is empty", false);
+    }
+
+    if(_file >= 0) {
+        // file is open
+        return;
+    }
+
+    _file = ::open(filename.c_str(), O_RDONLY);
+    if(-1 == _file) {
+        errorAndStop("File opening failed");
+    }
+
+    struct stat sb;
+    if (::fstat(_file, &sb) == -1) {
+        errorAndStop("fstat");
+    }
+    _fileSize = sb.st_size;
+
+    resetPosition();
+    mapWindow(0);
+}
+
+// close file
+void WMMapReader::close() {
+
+    unmapWindow();
+
+    if(_file >= 0) {
+        ::close(_file);
+        _file = -1;
+    }
+}
+
+void WMMapReader::unmapWindow() {
+
+    if(_winAddr) {
+        if(_dropCache) {
+            ::posix_fadvise(_file, _winOffset, _winSize, POSIX_FADV_DONTNEED);
+        }
+        ::munmap(_winAddr, _winSize);
+        _winAddr = nullptr;
+    }
+
+    _winBegin = _pos = _end = _nextAdvice = _released = nullptr;
+    _winSize = 0;
+}
+
+bool WMMapReader::mapWindow(size_t offset) {
+
+    unmapWindow();
+    _winOffset = offset;
+    if(offset >= _fileSize) {
+        return false;
+    }
+
+    assert(offset % _pageSize == 0);
+
+    _winSize = std::min(_windowSize, _fileSize - offset);
+    _winAddr = ::mmap(NULL, _winSize, PROT_READ, MAP_PRIVATE, _file, offset);
+    if(MAP_FAILED == _winAddr) {
+        _winAddr = nullptr;
+        errorAndStop("mmap");
+    }
+
+    ::madvise(_winAddr, _winSize, MADV_SEQUENTIAL);
+
+    _winBegin = _pos = _released = _nextAdvice = static_cast<const char*>(_winAddr);
+    _end = _winBegin + _winSize;
+
+    return true;
+}
+
+void WMMapReader::advise() {
+
+    // release pages behind the scan, the current page can have a part of the line
+    const char* releaseEnd = _winBegin + alignDown(_pos - _winBegin, _pageSize);
+    if(releaseEnd > _released) {
+        const size_t size = releaseEnd - _released;
+        ::madvise(const_cast<char*>(_released), size, MADV_DONTNEED);
+        if(_dropCache) {
+            ::posix_fadvise(_file, _winOffset + (_released - _winBegin), size,
+                                                        POSIX_FADV_DONTNEED);
+        }
+        _released = releaseEnd;
+    }
+
+    // read ahead
+    const size_t aheadSize = std::min<size_t>(2 * ADVICE_STEP, _end - releaseEnd);
+    if(aheadSize) {
+        ::madvise(const_cast<char*>(releaseEnd), aheadSize, MADV_WILLNEED);
+    }
+
+    _nextAdvice = releaseEnd + ADVICE_STEP;
+}
+
+// read next line in file
+FileLineRef WMMapReader::readLine() {
+
+    // It is experimental code and so I don't do correct error handling for all cases
+    assert(_file >= 0);
+    assert(_buffer && _bufferSize > 1);
+
+    size_t consumed = 0;
+    bool newline = false;
+    startLine();
+
+    for(;;) {
+        if(_pos == _end && !nextWindow()) {
+            // end of file, may be with the last line without newline
+            if(!consumed) {
+                return {};
+            }
+            break;
+        }
+
+        if(_pos >= _nextAdvice) {
+            advise();
+        }
+
+        const char* eol = static_cast<const char*>(std::memchr(_pos, '\n', _end - _pos));
+        const size_t partSize = (eol ? eol : _end) - _pos;
+        const size_t copySize = appendToLine(_pos, partSize);
+        consumed += copySize;
+        _pos += copySize;
+
+        if(copySize < partSize) {
+            // line is longer than the buffer and there is no overflow arena,
+            // the rest is the next line
+            break;
+        }
+
+        if(eol) {
+            // skip newline symbol, it is stripped by takeLine
+            ++_pos;
+            ++consumed;
+            newline = true;
+            break;
+        }
+
+        // the line continues in the next window
+    }
+
+    advancePosition(consumed);
+    return takeLine(newline);
+}
+
+bool WMMapReader::seek(size_t offset) {
+
+    assert(_file >= 0);
+
+    // begin from the previous symbol to see whether it is a newline
+    const size_t from = offset ? std::min(offset, _fileSize) - 1 : 0;
+    if(!mapWindow(alignDown(from, _pageSize))) {
+        resetPosition(_fileSize);
+        return true;
+    }
+    _pos = _winBegin + (from - _winOffset);
+
+    size_t pos = from;
+    if(offset) {
+        // skip the rest of the line (or only newline before the offset)
+        for(;;) {
+            if(_pos == _end && !nextWindow()) {
+                break;
+            }
+
+            const char* eol = static_cast<const char*>(std::memchr(_pos, '\n', _end - _pos));
+            if(eol) {
+                pos += eol + 1 - _pos;
+                _pos = eol + 1;
+                break;
+            }
+
+            pos += _end - _pos;
+            _pos = _end;
+        }
+    }
+
+    resetPosition(pos);
+    return true;
+}
+
+} // namespace fwc
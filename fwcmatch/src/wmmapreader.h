@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "filereader.h"
+
+namespace fwc {
+
+/*
+Reader for files which are much bigger than RAM. Unlike MMapReader it maps
+only a window of the file at a time and moves it forward. The kernel is
+advised to read ahead of the scan (MADV_WILLNEED) and pages behind the scan are
+released (MADV_DONTNEED), so resident memory is bounded with about two advice
+steps whatever the file size is. Optionally pages behind the scan are dropped
+from the page cache too, so a huge file doesn't evict everything else.
+Lines are copied into the line buffer because a window is unmapped while
+blocks with lines can still be processed by other threads, it also makes
+lines which cross a window boundary simple.
+*/
+
+class WMMapReader final: public FileReader
+{
+public:
+
+    static constexpr size_t DEFAULT_WINDOW_SIZE = 256*1024*1024;
+
+    explicit WMMapReader(size_t windowSize = DEFAULT_WINDOW_SIZE, bool dropCache = false);
+    ~WMMapReader();
+
+    // open file
+    void open(const std::string& filename) override;
+
+    // close file
+    void close() override;
+
+    bool needsBuffer() const override { return true; } ;
+
+    // read next line in file
+    // FileLineRef is used to avoid copying
+    FileLineRef readLine() override;
+
+    bool seek(size_t offset) override;
+    bool canSeek() const override { return true; }
+
+private:
+
+    // map the window which begins at the offset (it's aligned to pages),
+    // returns false at the end of file
+    bool mapWindow(size_t offset);
+    void unmapWindow();
+
+    // advise the kernel about pages ahead of and behind the current position
+    void advise();
+
+    // the next window or false at the end of file
+    bool nextWindow() { return mapWindow(_winOffset + _winSize); }
+
+    void*       _winAddr    { nullptr };
+    size_t      _winOffset  { 0 };
+    size_t      _winSize    { 0 };
+    const char* _winBegin   { nullptr };
+    const char* _pos        { nullptr };
+    const char* _end        { nullptr };
+    const char* _nextAdvice { nullptr };
+    const char* _released   { nullptr };
+    size_t      _fileSize   { 0 };
+    int         _file       { -1 };
+    const size_t _pageSize;
+    const size_t _windowSize;
+    const bool   _dropCache;
+};
+
+} // namespace fwc
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <type_traits>
+
+#include "noncopyable.h"
+#include "utils.h"
+
+namespace fwc {
+
+// Chase-Lev work-stealing deque with fixed capacity.
+// Only one thread (owner) can use push() and pop() at the bottom while any
+// thread can steal() from the top.
+// Based on "Correct and Efficient Work-Stealing for Weak Memory Models"
+// (N.M. Le, A. Pop, A. Cohen, F. Zappa Nardelli), without resizing
+// so there is no memory allocation after creation.
+// It is not general-purpose implementation.
+template <typename T>
+class WSDeque final: private noncopyable {
+public:
+    using Value = T;
+
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    explicit WSDeque(size_t capacity):
+        _buffer(roundUpPow2(capacity)),
+        _mask(_buffer.size() - 1) {
+
+        assert(capacity > 0);
+    }
+
+    // push to the bottom, owner only
+    // returns false if the deque is full
+    bool push(const Value& v) {
+        const auto bottom = _bottom.load(std::memory_order_relaxed);
+        const auto top = _top.load(std::memory_order_acquire);
+        if(bottom - top >= static_cast<int64_t>(_buffer.size())) {
+            return false; // full
+        }
+
+        _buffer[bottom & _mask].store(v, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // pop from the bottom, owner only
+    // returns false if the deque is empty
+    bool pop(Value& v) {
+        const auto bottom = _bottom.load(std::memory_order_relaxed) - 1;
+        _bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto top = _top.load(std::memory_order_relaxed);
+
+        if(top > bottom) {
+            // empty
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        v = _buffer[bottom & _mask].load(std::memory_order_relaxed);
+        if(top != bottom) {
+            return true;
+        }
+
+        // the last item, race with thieves
+        const bool won = _top.compare_exchange_strong(top, top + 1,
+                        std::memory_order_seq_cst, std::memory_order_relaxed);
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+        return won;
+    }
+
+    // steal from the top, any thread
+    // returns false if the deque is empty or another thread won the race
+    bool steal(Value& v) {
+        auto top = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const auto bottom = _bottom.load(std::memory_order_acquire);
+
+        if(top >= bottom) {
+            return false; // empty
+        }
+
+        v = _buffer[top & _mask].load(std::memory_order_relaxed);
+        return _top.compare_exchange_strong(top, top + 1,
+                        std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] size_t capacity() const noexcept { return _buffer.size(); }
+
+    // reset to initial state
+    // not thread safe
+    void reset() noexcept {
+        _top = 0;
+        _bottom = 0;
+    }
+
+private:
+    using int64_t = std::int64_t;
+
+    static size_t roundUpPow2(size_t v) noexcept {
+        size_t result = 1;
+        while(result < v) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    std::vector<std::atomic<T>>                 _buffer;
+    const size_t                                _mask;
+    alignas(CACHE_LINE_SIZE) std::atomic<int64_t> _top    { 0 };
+    alignas(CACHE_LINE_SIZE) std::atomic<int64_t> _bottom { 0 };
+};
+
+} // namespace fwc
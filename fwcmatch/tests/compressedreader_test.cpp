@@ -0,0 +1,125 @@
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "compressedreader.h"
+#include "mywildcard.h"
+#include "noncopyable.h"
+#include "seqproc.h"
+#include "utils.h"
+
+/*
+Gzip files of several members and with padding or garbage after the last
+member (like block-padded archives) must be read like gzip does it: all
+members are decompressed and the tail is ignored.
+*/
+
+using namespace fwc;
+
+namespace {
+
+constexpr size_t LINES_PER_MEMBER = 1000;
+
+// lines 'first'...'first + count' with "needle" in every tenth one
+std::string makeLines(size_t first, size_t count) {
+    std::string text;
+    for(size_t i = first; i < first + count; ++i) {
+        text += "line " + std::to_string(i) + (i % 10 ? "\n" : " needle\n");
+    }
+    return text;
+}
+
+// one gzip member
+std::string gzipMember(const std::string& text) {
+
+    z_stream zs {};
+    // 16 means gzip header
+    if(deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                                        Z_DEFAULT_STRATEGY) != Z_OK) {
+        errorAndStop("deflateInit2 failed", false);
+    }
+
+    std::string result(deflateBound(&zs, text.size()), '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(text.data()));
+    zs.avail_in = text.size();
+    zs.next_out = reinterpret_cast<Bytef*>(result.data());
+    zs.avail_out = result.size();
+    if(deflate(&zs, Z_FINISH) != Z_STREAM_END) {
+        errorAndStop("deflate failed", false);
+    }
+    result.resize(result.size() - zs.avail_out);
+    deflateEnd(&zs);
+    return result;
+}
+
+// removes the file when the test ends
+class TempFile final: private noncopyable
+{
+public:
+    explicit TempFile(const std::string& content):
+        _name((std::filesystem::temp_directory_path() /
+                    ("fwcmatch-compressed-" + std::to_string(::getpid()) + ".gz")).string()) {
+
+        FILE* file = std::fopen(_name.c_str(), "wb");
+        if(!file || std::fwrite(content.data(), 1, content.size(), file) != content.size()) {
+            errorAndStop("Test file writing failed");
+        }
+        std::fclose(file);
+    }
+
+    ~TempFile() {
+        std::remove(_name.c_str());
+    }
+
+    [[nodiscard]]
+    const std::string& name() const noexcept { return _name; }
+
+private:
+    const std::string _name;
+};
+
+// the file of 'members' members and the tail must give all lines
+bool check(const char* name, size_t members, const std::string& tail) {
+
+    std::string content;
+    for(size_t m = 0; m < members; ++m) {
+        content += gzipMember(makeLines(m * LINES_PER_MEMBER, LINES_PER_MEMBER));
+    }
+    content += tail;
+    TempFile file(content);
+
+    auto freader = CompressedReader();
+    auto wcmatch = MyWildcardMatch();
+    auto processor = SequentialProcessor(64, freader.needsBuffer());
+
+    const size_t lines   = processor.execute(freader, file.name(), wcmatch, "*");
+    const size_t needles = processor.execute(freader, file.name(), wcmatch, "*needle");
+    const size_t expected = members * LINES_PER_MEMBER;
+    if(lines != expected || needles != expected / 10) {
+        std::cerr << name << ": " << lines << " lines and " << needles
+                  << " needles instead of " << expected << " and "
+                  << expected / 10 << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+int main() {
+
+    size_t failed = 0;
+    failed += !check("one member", 1, {});
+    failed += !check("three members", 3, {});
+    failed += !check("zero padding", 2, std::string(4096, '\0'));
+    failed += !check("one zero byte", 2, std::string(1, '\0'));
+    failed += !check("garbage", 2, "trailing garbage\n");
+    failed += !check("first magic byte", 2, "\x1f");
+
+    std::cout << failed << " failed" << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <fnmatch.h>
+
+#include "globwildcard.h"
+
+/*
+Differential test of GlobMatch against fnmatch of libc: random patterns and
+texts are matched with every combination of the supported flags.
+Empty patterns and texts are not generated because CompiledPattern treats
+them like grep does (an empty pattern matches everything).
+*/
+
+using namespace fwc;
+
+namespace {
+
+constexpr int FLAGS[] = { FNM_NOESCAPE, FNM_PATHNAME, FNM_PERIOD, FNM_CASEFOLD };
+constexpr int NUM_OF_FLAG_SETS = 1 << std::size(FLAGS);
+
+constexpr size_t MAX_REPORTED = 20;
+
+std::mt19937 rng(7);
+
+std::string randomString(const std::string& symbols, size_t maxSize) {
+    std::string result;
+    const size_t size = rng() % maxSize + 1;
+    for(size_t i = 0; i < size; ++i) {
+        result += symbols[rng() % symbols.size()];
+    }
+    return result;
+}
+
+// pattern made of whole tokens, so brackets are mostly valid
+std::string randomTokens(size_t maxTokens) {
+    static const char* const TOKENS[] = {
+        "a", "A", ".", "/", "*", "?", "[[:alpha:]]", "[[:upper:]]", "[![:digit:]]",
+        "[[.-.]]", "[[=a=]]", "[a-z]", "[!b]", "\\*", "\\[", "[[:foo:]]", "[.a]", "1",
+        "[A-Z]", "[[=a=]-c]", "[[.A.]-Z]", "[[:lower:]A]", "[]a]", "[!]/]"
+    };
+
+    std::string result;
+    const size_t size = rng() % maxTokens + 1;
+    for(size_t i = 0; i < size; ++i) {
+        result += TOKENS[rng() % std::size(TOKENS)];
+    }
+    return result;
+}
+
+class Checker final
+{
+public:
+    void check(const std::string& pattern, const std::string& text) {
+        for(int set = 0; set < NUM_OF_FLAG_SETS; ++set) {
+            int flags = 0;
+            for(size_t idx = 0; idx < std::size(FLAGS); ++idx) {
+                if(set & (1 << idx)) {
+                    flags |= FLAGS[idx];
+                }
+            }
+
+            const bool expected = 0 == ::fnmatch(pattern.c_str(), text.c_str(), flags);
+            const bool actual = GlobMatch(flags).compile(pattern)->isMatch(text);
+            ++_total;
+            _matched += expected;
+            if(expected != actual && ++_failed <= MAX_REPORTED) {
+                std::cerr << "pattern '" << pattern << "' text '" << text
+                          << "' flags " << flags << ": fnmatch " << expected
+                          << ", GlobMatch " << actual << std::endl;
+            }
+        }
+    }
+
+    [[nodiscard]]
+    bool report() const {
+        std::cout << _total << " checks, " << _matched << " matched, "
+                  << _failed << " failed" << std::endl;
+        return !_failed;
+    }
+
+private:
+    size_t _total   { 0 };
+    size_t _matched { 0 };
+    size_t _failed  { 0 };
+};
+
+} // anonymous namespace
+
+int main() {
+
+    Checker checker;
+
+    // any bytes of the syntax, brackets are often unclosed or odd
+    const std::string patternSymbols = "ab.A/*?[]!\\-^:=";
+    const std::string textSymbols = "ab.A/-]B";
+    for(int i = 0; i < 40000; ++i) {
+        const bool simple = i % 3;
+        checker.check(randomString(simple ? patternSymbols.substr(0, 7) : patternSymbols, 10),
+                      randomString(textSymbols, 30));
+    }
+
+    // classes, collating elements and ranges
+    for(int i = 0; i < 20000; ++i) {
+        checker.check(randomTokens(6), randomString("aAbB1./-*[Z]", 20));
+    }
+
+    return checker.report() ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+#include <cstddef>
+#include <cstdio>
+#include <array>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+#include "fgetsreader.h"
+#include "fstreamreader.h"
+#include "mmapreader.h"
+#include "mtcondvarproc.h"
+#include "mywildcard.h"
+#include "noncopyable.h"
+#include "seqproc.h"
+#include "utils.h"
+
+/*
+Buffered readers must count the same lines as MMapReader which never splits
+them: the test file has lines much longer than a buffer block of a lines
+block (BlocksBuffer::DEFAULT_BLOCK_SIZE and BLOCK_SIZE of processors), CRLF
+endings and the last line without newline.
+*/
+
+using namespace fwc;
+
+namespace {
+
+constexpr size_t MAX_LONG_LINE = 8 * BlocksBuffer::DEFAULT_BLOCK_SIZE;
+
+std::string makeContent() {
+
+    std::mt19937 rng(20);
+    std::string content;
+    for(int i = 0; i < 5000; ++i) {
+        const bool isLong = rng() % 8 == 0;
+        const size_t size = isLong ? rng() % MAX_LONG_LINE : rng() % 100;
+
+        std::string line(size, 'a' + rng() % 26);
+        if(rng() % 3 == 0) {
+            // the needle is at the end of long lines, so a split moves it
+            line += "needle";
+        }
+        content += line;
+        content += rng() % 2 ? "\r\n" : "\n";
+    }
+
+    // and the same at the very end of the file
+    content += std::string(3 * BlocksBuffer::DEFAULT_BLOCK_SIZE, 'z');
+    content += "last needle without newline";
+    return content;
+}
+
+// removes the file when the test ends
+class TempFile final: private noncopyable
+{
+public:
+    explicit TempFile(const std::string& content):
+        _name((std::filesystem::temp_directory_path() /
+                    ("fwcmatch-readers-" + std::to_string(::getpid()) + ".txt")).string()) {
+
+        FILE* file = std::fopen(_name.c_str(), "wb");
+        if(!file || std::fwrite(content.data(), 1, content.size(), file) != content.size()) {
+            errorAndStop("Test file writing failed");
+        }
+        std::fclose(file);
+    }
+
+    ~TempFile() {
+        std::remove(_name.c_str());
+    }
+
+    [[nodiscard]]
+    const std::string& name() const noexcept { return _name; }
+
+private:
+    const std::string _name;
+};
+
+class Checker final
+{
+public:
+    explicit Checker(const std::string& filename): _filename(filename) {
+    }
+
+    // counts of lines with the pattern by the sequential and
+    // a producer-consumer processor
+    template<typename FReader>
+    void check(const char* readerName, const std::string& pattern) {
+        const auto expected = count<MMapReader>(pattern);
+        const auto actual = count<FReader>(pattern);
+        for(size_t idx = 0; idx < actual.size(); ++idx) {
+            if(actual[idx] != expected[idx]) {
+                ++_failed;
+                std::cerr << readerName << ", pattern '" << pattern << "', processor "
+                          << idx << ": " << actual[idx] << " lines instead of "
+                          << expected[idx] << std::endl;
+            }
+        }
+    }
+
+    [[nodiscard]]
+    bool report() const {
+        std::cout << _failed << " failed" << std::endl;
+        return !_failed;
+    }
+
+private:
+
+    template<typename FReader>
+    std::array<size_t, 3> count(const std::string& pattern) {
+        auto freader = FReader();
+        auto wcmatch = MyWildcardMatch();
+        auto cpattern = wcmatch.compile(pattern);
+
+        auto sequential = SequentialProcessor(64, freader.needsBuffer());
+        auto budgeted = SequentialProcessor(BlockLimits::ofBytes(16 * 1024), freader.needsBuffer());
+        auto condVar = MTCondVarProcessor(8, 2, 64, freader.needsBuffer());
+
+        return {
+            sequential.execute(freader, _filename, *cpattern),
+            budgeted.execute(freader, _filename, *cpattern),
+            condVar.execute(freader, _filename, *cpattern)
+        };
+    }
+
+    const std::string _filename;
+    size_t            _failed { 0 };
+};
+
+} // anonymous namespace
+
+int main() {
+
+    TempFile file(makeContent());
+    Checker checker(file.name());
+
+    for(const std::string pattern: { "*", "*needle", "*needle*", "a*" }) {
+        checker.check<FGetsReader>("FGetsReader", pattern);
+        checker.check<FStreamReader>("FStreamReader", pattern);
+    }
+
+    return checker.report() ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include "regexmatch.h"
+
+/*
+Test of RegexMatch with known results. Invalid expressions stop the program,
+so an expression given as the argument is only compiled: ctest runs it for
+invalid expressions and checks the error message.
+*/
+
+using namespace fwc;
+
+namespace {
+
+struct Case final {
+    const char* regex;
+    const char* text;
+    bool        ignoreCase;
+    bool        expected;
+};
+
+constexpr Case CASES[] = {
+    { "failed",              "copy failed: no space",  false, true  },
+    { "failed",              "copy FAILED",            false, false },
+    { "failed",              "copy FAILED",            true,  true  },
+    { "^copy",               "copy failed",            false, true  },
+    { "^failed",             "copy failed",            false, false },
+    { "space$",              "no space",               false, true  },
+    { "(copied|deleted) .*file", "deleted old file",   false, true  },
+    { "(copied|deleted) .*file", "moved old file",     false, false },
+    { "[[:digit:]]{2,}",     "error 42",               false, true  },
+    { "[[:digit:]]{2,}",     "error 4",                false, false },
+    { "[[:upper:]]+",        "error",                  true,  false },
+    { "[[.-.]]x",            "a-x",                    false, true  },
+    { "[^a-z]",              "abc",                    false, false },
+    { "\\d\\s\\w",           "1 a",                    false, true  },
+    { "a{2}b|^c$",           "c",                      false, true  },
+};
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+
+    if(argc > 1) {
+        auto cpattern = RegexMatch().compile(argv[1]);
+        std::cout << "'" << argv[1] << "' is compiled" << std::endl;
+        return 1;
+    }
+
+    size_t failed = 0;
+    for(auto const& test: CASES) {
+        const bool actual = RegexMatch(test.ignoreCase).compile(test.regex)->isMatch(test.text);
+        if(actual != test.expected) {
+            ++failed;
+            std::cerr << "regex '" << test.regex << "' text '" << test.text
+                      << "' ignoreCase " << test.ignoreCase << ": " << actual
+                      << " instead of " << test.expected << std::endl;
+        }
+    }
+
+    std::cout << std::size(CASES) << " checks, " << failed << " failed" << std::endl;
+    return failed ? 1 : 0;
+}